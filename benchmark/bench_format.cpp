@@ -0,0 +1,477 @@
+#include <formatpp/format.h>
+#include <benchmark/benchmark.h>
+#include "harness.h"
+#include "inputs.h"
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#define FORMATPP_BENCH_TO_CHARS 1
+#endif
+#endif
+
+using namespace formatpp;
+
+using bench::integers;
+using bench::floats;
+using bench::strings;
+using bench::next;
+
+//////////////////////////////////////////////////////////////////////////////
+// Built-in formatters, into a reused std::string
+
+template <typename T>
+void BM_Integer(benchmark::State &state, T, const char *format)
+{
+    const auto &values = integers<T>();
+    std::string out;
+    size_t i = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        out.clear();
+        format_to(out, format, next(values, i));
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_Integer, int16_dec, int16_t(), "{}");
+BENCHMARK_CAPTURE(BM_Integer, int16_hex, int16_t(), "{:x}");
+BENCHMARK_CAPTURE(BM_Integer, int32_dec, int32_t(), "{}");
+BENCHMARK_CAPTURE(BM_Integer, int32_hex, int32_t(), "{:x}");
+BENCHMARK_CAPTURE(BM_Integer, int32_oct, int32_t(), "{:o}");
+BENCHMARK_CAPTURE(BM_Integer, int32_bin, int32_t(), "{:b}");
+BENCHMARK_CAPTURE(BM_Integer, int32_width, int32_t(), "{:12}");
+BENCHMARK_CAPTURE(BM_Integer, int32_zero_pad, int32_t(), "{:012}");
+BENCHMARK_CAPTURE(BM_Integer, int64_dec, int64_t(), "{}");
+BENCHMARK_CAPTURE(BM_Integer, int64_hex, int64_t(), "{:x}");
+BENCHMARK_CAPTURE(BM_Integer, uint64_dec, uint64_t(), "{}");
+BENCHMARK_CAPTURE(BM_Integer, uint64_hex, uint64_t(), "{:X}");
+BENCHMARK_CAPTURE(BM_Integer, uint64_oct, uint64_t(), "{:o}");
+BENCHMARK_CAPTURE(BM_Integer, uint64_bin, uint64_t(), "{:b}");
+
+template <typename T>
+void BM_Float(benchmark::State &state, T, const char *format)
+{
+    const auto &values = floats<T>();
+    std::string out;
+    size_t i = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        out.clear();
+        format_to(out, format, next(values, i));
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// One case per fp_format_mode: automatic, positional, scientific, binary_repr
+BENCHMARK_CAPTURE(BM_Float, float_automatic, float(), "{}");
+BENCHMARK_CAPTURE(BM_Float, float_positional, float(), "{:.3f}");
+BENCHMARK_CAPTURE(BM_Float, float_scientific, float(), "{:e}");
+BENCHMARK_CAPTURE(BM_Float, float_binary_repr, float(), "{:x}");
+BENCHMARK_CAPTURE(BM_Float, double_automatic, double(), "{}");
+BENCHMARK_CAPTURE(BM_Float, double_positional, double(), "{:f}");
+BENCHMARK_CAPTURE(BM_Float, double_positional_precision, double(), "{:.3f}");
+BENCHMARK_CAPTURE(BM_Float, double_scientific, double(), "{:e}");
+BENCHMARK_CAPTURE(BM_Float, double_binary_repr, double(), "{:x}");
+BENCHMARK_CAPTURE(BM_Float, double_width, double(), "{:>16.2f}");
+
+void BM_String(benchmark::State &state, const char *format)
+{
+    const auto &values = strings();
+    std::string out;
+    size_t i = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        out.clear();
+        format_to(out, format, next(values, i));
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_String, plain, "{}");
+BENCHMARK_CAPTURE(BM_String, precision, "{:.8}");
+BENCHMARK_CAPTURE(BM_String, width, "{:24}");
+BENCHMARK_CAPTURE(BM_String, width_precision, "{:<24.8}");
+BENCHMARK_CAPTURE(BM_String, center, "{:*^40}");
+BENCHMARK_CAPTURE(BM_String, json, "{:j}");
+BENCHMARK_CAPTURE(BM_String, columns, "{:24w}");
+
+void BM_CString(benchmark::State &state, const char *format)
+{
+    const auto &values = strings();
+    std::string out;
+    size_t i = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        out.clear();
+        format_to(out, format, next(values, i).c_str());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_CString, plain, "{}");
+BENCHMARK_CAPTURE(BM_CString, width_precision, "{:<24.8}");
+
+void BM_Bool(benchmark::State &state, const char *format)
+{
+    std::string out;
+    size_t i = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        out.clear();
+        format_to(out, format, (i++ & 1) != 0);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_Bool, plain, "{}");
+BENCHMARK_CAPTURE(BM_Bool, capitalized, "{:B}");
+BENCHMARK_CAPTURE(BM_Bool, numeric, "{:i}");
+BENCHMARK_CAPTURE(BM_Bool, width, "{:>8}");
+
+//////////////////////////////////////////////////////////////////////////////
+// Output targets, with a typical mixed format
+
+const char *const mixed_format = "{} {} {}";
+
+void BM_Output_string(benchmark::State &state)
+{
+    const auto &ints = integers<int32_t>();
+    const auto &doubles = floats<double>();
+    std::string out;
+    size_t i = 0, j = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        out.clear();
+        format_to(out, mixed_format, next(ints, i), next(doubles, j), "asdf");
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Output_string);
+
+void BM_Output_format_str(benchmark::State &state)
+{
+    const auto &ints = integers<int32_t>();
+    const auto &doubles = floats<double>();
+    size_t i = 0, j = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        std::string out = format_str(mixed_format, next(ints, i), next(doubles, j), "asdf");
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Output_format_str);
+
+void BM_Output_char_buf(benchmark::State &state)
+{
+    const auto &ints = integers<int32_t>();
+    const auto &doubles = floats<double>();
+    char storage[256];
+    size_t i = 0, j = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        char_buf<char> out(storage, sizeof(storage));
+        format_to(out, mixed_format, next(ints, i), next(doubles, j), "asdf");
+        benchmark::DoNotOptimize(storage);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Output_char_buf);
+
+void BM_Output_ostream(benchmark::State &state)
+{
+    const auto &ints = integers<int32_t>();
+    const auto &doubles = floats<double>();
+    std::ostringstream out;
+    size_t i = 0, j = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        out.seekp(0);
+        format_to(out, mixed_format, next(ints, i), next(doubles, j), "asdf");
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Output_ostream);
+
+//////////////////////////////////////////////////////////////////////////////
+// Argument count scaling and long literal templates
+
+template <typename... Args>
+void BM_Args(benchmark::State &state, const char *format, Args... args)
+{
+    std::string out;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        out.clear();
+        format_to(out, format, args...);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_Args, 1, "{}", 12345);
+BENCHMARK_CAPTURE(BM_Args, 2, "{} {}", 12345, 1.5);
+BENCHMARK_CAPTURE(BM_Args, 4, "{} {} {} {}", 12345, 1.5, "abc", true);
+BENCHMARK_CAPTURE(BM_Args, 8, "{} {} {} {} {} {} {} {}",
+                  12345, 1.5, "abc", true, 12345, 1.5, "abc", true);
+BENCHMARK_CAPTURE(BM_Args, 16, "{} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {}",
+                  12345, 1.5, "abc", true, 12345, 1.5, "abc", true,
+                  12345, 1.5, "abc", true, 12345, 1.5, "abc", true);
+BENCHMARK_CAPTURE(BM_Args, indexed, "{3} {2} {1} {0}", 12345, 1.5, "abc", true);
+
+void BM_LongLiteral(benchmark::State &state)
+{
+    std::string format(state.range(0), 'x');
+    format.insert(format.size() / 2, " {} ");
+    format += " {}";
+    std::string out;
+    int n = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        out.clear();
+        format_to(out, format.c_str(), n++, "end");
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * format.size());
+}
+BENCHMARK(BM_LongLiteral)->Arg(64)->Arg(1024)->Arg(16384);
+
+void BM_ManyLiterals(benchmark::State &state)
+{
+    std::string out;
+    int n = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        out.clear();
+        format_to(out, "id={} name={} x={:.2f} y={:.2f} ok={} {{braces}} done", n++, "node", 1.5, 2.25, true);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ManyLiterals);
+
+//////////////////////////////////////////////////////////////////////////////
+// Baselines
+
+template <typename T>
+void BM_Integer_snprintf(benchmark::State &state, T, const char *format)
+{
+    const auto &values = integers<T>();
+    char buf[72];
+    size_t i = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        int n = std::snprintf(buf, sizeof(buf), format, static_cast<long long>(next(values, i)));
+        benchmark::DoNotOptimize(n);
+        benchmark::DoNotOptimize(buf);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_Integer_snprintf, int32_dec, int32_t(), "%lld");
+BENCHMARK_CAPTURE(BM_Integer_snprintf, int32_hex, int32_t(), "%llx");
+BENCHMARK_CAPTURE(BM_Integer_snprintf, int64_dec, int64_t(), "%lld");
+BENCHMARK_CAPTURE(BM_Integer_snprintf, int64_hex, int64_t(), "%llx");
+
+template <typename T>
+void BM_Float_snprintf(benchmark::State &state, T, const char *format)
+{
+    const auto &values = floats<T>();
+    char buf[512];
+    size_t i = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        int n = std::snprintf(buf, sizeof(buf), format, static_cast<double>(next(values, i)));
+        benchmark::DoNotOptimize(n);
+        benchmark::DoNotOptimize(buf);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_Float_snprintf, double_automatic, double(), "%g");
+BENCHMARK_CAPTURE(BM_Float_snprintf, double_positional, double(), "%f");
+BENCHMARK_CAPTURE(BM_Float_snprintf, double_positional_precision, double(), "%.3f");
+BENCHMARK_CAPTURE(BM_Float_snprintf, double_scientific, double(), "%e");
+BENCHMARK_CAPTURE(BM_Float_snprintf, double_binary_repr, double(), "%a");
+
+void BM_String_snprintf(benchmark::State &state, const char *format)
+{
+    const auto &values = strings();
+    char buf[64];
+    size_t i = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        int n = std::snprintf(buf, sizeof(buf), format, next(values, i).c_str());
+        benchmark::DoNotOptimize(n);
+        benchmark::DoNotOptimize(buf);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_String_snprintf, plain, "%s");
+BENCHMARK_CAPTURE(BM_String_snprintf, width_precision, "%-24.8s");
+
+void BM_Mixed_snprintf(benchmark::State &state)
+{
+    const auto &ints = integers<int32_t>();
+    const auto &doubles = floats<double>();
+    size_t i = 0, j = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        char buf[64];
+        int n = std::snprintf(buf, sizeof(buf), "%i %g %s", next(ints, i), next(doubles, j), "asdf");
+        std::string out(buf, n);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Mixed_snprintf);
+
+void BM_Mixed_ostringstream(benchmark::State &state)
+{
+    const auto &ints = integers<int32_t>();
+    const auto &doubles = floats<double>();
+    size_t i = 0, j = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        std::ostringstream ss;
+        ss << next(ints, i) << " " << next(doubles, j) << " " << "asdf";
+        std::string out = ss.str();
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Mixed_ostringstream);
+
+template <typename T>
+void BM_Integer_ostringstream(benchmark::State &state, T, bool hex)
+{
+    const auto &values = integers<T>();
+    std::ostringstream ss;
+    if (hex)
+        ss << std::hex;
+    size_t i = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        ss.seekp(0);
+        ss << next(values, i);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_Integer_ostringstream, int32_dec, int32_t(), false);
+BENCHMARK_CAPTURE(BM_Integer_ostringstream, int32_hex, int32_t(), true);
+BENCHMARK_CAPTURE(BM_Integer_ostringstream, int64_dec, int64_t(), false);
+
+void BM_Float_ostringstream(benchmark::State &state)
+{
+    const auto &values = floats<double>();
+    std::ostringstream ss;
+    size_t i = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        ss.seekp(0);
+        ss << next(values, i);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Float_ostringstream);
+
+#ifdef FORMATPP_BENCH_TO_CHARS
+template <typename T>
+void BM_Integer_to_chars(benchmark::State &state, T, int base)
+{
+    const auto &values = integers<T>();
+    char buf[72];
+    size_t i = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        auto result = std::to_chars(buf, buf + sizeof(buf), next(values, i), base);
+        benchmark::DoNotOptimize(result.ptr);
+        benchmark::DoNotOptimize(buf);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_Integer_to_chars, int32_dec, int32_t(), 10);
+BENCHMARK_CAPTURE(BM_Integer_to_chars, int32_hex, int32_t(), 16);
+BENCHMARK_CAPTURE(BM_Integer_to_chars, int32_bin, int32_t(), 2);
+BENCHMARK_CAPTURE(BM_Integer_to_chars, int64_dec, int64_t(), 10);
+BENCHMARK_CAPTURE(BM_Integer_to_chars, uint64_hex, uint64_t(), 16);
+
+template <typename T>
+void BM_Float_to_chars(benchmark::State &state, T, std::chars_format fmt, int precision)
+{
+    const auto &values = floats<T>();
+    char buf[512];
+    size_t i = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        auto result = precision < 0
+            ? std::to_chars(buf, buf + sizeof(buf), next(values, i), fmt)
+            : std::to_chars(buf, buf + sizeof(buf), next(values, i), fmt, precision);
+        benchmark::DoNotOptimize(result.ptr);
+        benchmark::DoNotOptimize(buf);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_Float_to_chars, double_shortest, double(), std::chars_format::general, -1);
+BENCHMARK_CAPTURE(BM_Float_to_chars, double_positional, double(), std::chars_format::fixed, 6);
+BENCHMARK_CAPTURE(BM_Float_to_chars, double_positional_precision, double(), std::chars_format::fixed, 3);
+BENCHMARK_CAPTURE(BM_Float_to_chars, double_scientific, double(), std::chars_format::scientific, 6);
+BENCHMARK_CAPTURE(BM_Float_to_chars, double_binary_repr, double(), std::chars_format::hex, -1);
+#endif
+
+/// Besides the Google Benchmark flags, accepts `--perf_counters` to report hardware counters per operation
+int main(int argc, char **argv)
+{
+    int n = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!std::strcmp(argv[i], "--perf_counters"))
+            bench::perf_counters::instance().open();
+        else
+            argv[n++] = argv[i];
+    }
+    argc = n;
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,215 @@
+#include <formatpp/format.h>
+#include <benchmark/benchmark.h>
+#include "harness.h"
+#include "inputs.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+// Scalability: every benchmark runs on 1, 2, 4, ... hardware_concurrency threads. Throughput
+// (items_per_second, in real time) is the total of all threads; p50_ns and p99_ns are
+// per-call latencies, averaged over the threads.
+
+using namespace formatpp;
+
+namespace {
+
+/// Times every `sample_every`-th call, to keep the clock reads from dominating short calls
+class latency_recorder
+{
+public:
+    enum : size_t { sample_every = 16 };
+
+    latency_recorder()
+    {
+        samples.reserve(1 << 16);
+    }
+
+    template <typename F>
+    void run(F &&f)
+    {
+        if (calls++ % sample_every)
+        {
+            f();
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+
+    void report(benchmark::State &state)
+    {
+        if (samples.empty())
+            return;
+        state.counters["p50_ns"] = benchmark::Counter(percentile(0.50), benchmark::Counter::kAvgThreads);
+        state.counters["p99_ns"] = benchmark::Counter(percentile(0.99), benchmark::Counter::kAvgThreads);
+    }
+
+private:
+    double percentile(double p)
+    {
+        size_t k = static_cast<size_t>(p * (samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+        return samples[k];
+    }
+
+    std::vector<double> samples;
+    size_t calls = 0;
+};
+
+/// Writes to /dev/null with `fwrite`, which takes the `FILE` lock like `std::cout` synchronized with stdio
+class stdio_streambuf : public std::streambuf
+{
+public:
+    stdio_streambuf() : file(std::fopen("/dev/null", "w")) {}
+    ~stdio_streambuf() { if (file) std::fclose(file); }
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        if (file && c != traits_type::eof())
+            std::fputc(c, file);
+        return c;
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n) override
+    {
+        return file ? static_cast<std::streamsize>(std::fwrite(s, 1, n, file)) : n;
+    }
+
+private:
+    std::FILE *file;
+};
+
+/// One formatted call with mixed arguments
+template <typename Output>
+void format_mixed(Output &out, size_t &i)
+{
+    format_to(out, "{} {:.3f} {:>12}", bench::next(bench::integers<int32_t>(), i),
+              bench::next(bench::floats<double>(), i), bench::next(bench::strings(), i));
+}
+
+void BM_Threads_string(benchmark::State &state)
+{
+    std::string out;
+    latency_recorder latency;
+    size_t i = state.thread_index() * 97;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        latency.run([&]()
+        {
+            out.clear();
+            format_mixed(out, i);
+        });
+        benchmark::DoNotOptimize(out.data());
+    }
+    latency.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+
+/// A new string for every call - exercises the global allocator
+void BM_Threads_format_str(benchmark::State &state)
+{
+    latency_recorder latency;
+    size_t i = state.thread_index() * 97;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        latency.run([&]()
+        {
+            std::string out = format_str("{} {:.3f} {:>40}", bench::next(bench::integers<int32_t>(), i),
+                                         bench::next(bench::floats<double>(), i), bench::next(bench::strings(), i));
+            benchmark::DoNotOptimize(out.data());
+        });
+    }
+    latency.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_Threads_char_buf(benchmark::State &state)
+{
+    char storage[256];
+    latency_recorder latency;
+    size_t i = state.thread_index() * 97;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        latency.run([&]()
+        {
+            char_buf<char> buf(storage, sizeof(storage));
+            format_mixed(buf, i);
+        });
+        benchmark::DoNotOptimize(storage);
+    }
+    latency.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+
+/// All threads print to the shared `std::cout`, redirected to /dev/null
+void BM_Threads_print(benchmark::State &state)
+{
+    static stdio_streambuf null_stdio;
+    static std::streambuf *saved;
+    if (state.thread_index() == 0)
+        saved = std::cout.rdbuf(&null_stdio);
+    latency_recorder latency;
+    size_t i = state.thread_index() * 97;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        latency.run([&]()
+        {
+            print("{} {:.3f} {:>12}\n", bench::next(bench::integers<int32_t>(), i),
+                  bench::next(bench::floats<double>(), i), bench::next(bench::strings(), i));
+        });
+    }
+    latency.report(state);
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+        std::cout.rdbuf(saved);
+}
+
+/// Values needing a temporary buffer larger than the output context's static one, allocated on every call
+void BM_Threads_tmp_spill(benchmark::State &state)
+{
+    std::string out;
+    latency_recorder latency;
+    size_t i = state.thread_index() * 97;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        latency.run([&]()
+        {
+            out.clear();
+            format_to(out, "{:.300f}", bench::next(bench::floats<double>(), i));
+        });
+        benchmark::DoNotOptimize(out.data());
+    }
+    latency.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+
+void thread_counts(benchmark::internal::Benchmark *b)
+{
+    int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    int n = 1;
+    for (; n < max_threads; n *= 2)
+        b->Threads(n);
+    b->Threads(max_threads);
+    b->UseRealTime();
+}
+
+} // namespace
+
+BENCHMARK(BM_Threads_string)->Apply(thread_counts);
+BENCHMARK(BM_Threads_format_str)->Apply(thread_counts);
+BENCHMARK(BM_Threads_char_buf)->Apply(thread_counts);
+BENCHMARK(BM_Threads_print)->Apply(thread_counts);
+BENCHMARK(BM_Threads_tmp_spill)->Apply(thread_counts);
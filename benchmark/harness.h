@@ -0,0 +1,44 @@
+#ifndef FORMATPP_BENCHMARK_HARNESS_H_
+#define FORMATPP_BENCHMARK_HARNESS_H_
+
+#include <benchmark/benchmark.h>
+#include "alloc_counter.h"
+#include "perf_counters.h"
+
+namespace bench {
+
+/// @brief Measures the benchmark loop that follows: `bench::scope scope(state); for (auto _ : state) ...`
+///
+/// Reports heap allocations and allocated bytes per iteration and, if enabled,
+/// the hardware counters. The hardware counters are per thread, so they are
+/// skipped in multi-threaded runs.
+class scope
+{
+public:
+    explicit scope(benchmark::State &state)
+    : state(state), perf(perf_counters::instance().enabled() && state.threads() == 1)
+    {
+        if (perf)
+            perf_counters::instance().start();
+    }
+
+    ~scope()
+    {
+        if (perf)
+            perf_counters::instance().stop(state);
+        alloc_counter::stats allocs = alloc.delta();
+        state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocs.allocations),
+                                                      benchmark::Counter::kAvgIterations);
+        state.counters["alloc_bytes"] = benchmark::Counter(static_cast<double>(allocs.bytes),
+                                                           benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    benchmark::State &state;
+    bool perf;
+    alloc_counter::scope alloc;
+};
+
+} // bench
+
+#endif
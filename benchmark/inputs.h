@@ -0,0 +1,82 @@
+#ifndef FORMATPP_BENCHMARK_INPUTS_H_
+#define FORMATPP_BENCHMARK_INPUTS_H_
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace bench {
+
+/// Number of distinct input values each benchmark cycles through; a power of 2
+constexpr size_t num_values = 1024;
+
+template <typename T>
+inline const std::vector<T> &integers()
+{
+    static const std::vector<T> values = []
+    {
+        std::mt19937_64 rng(42);
+        std::vector<T> v(num_values);
+        const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<T>::max());
+        for (auto &x : v)
+        {
+            // A random shift gives a mix of magnitudes, i.e. of digit counts
+            uint64_t r = (rng() >> (rng() % 64)) % limit;
+            x = static_cast<T>(r);
+            if (std::is_signed<T>::value && (rng() & 1))
+                x = static_cast<T>(0 - x);
+        }
+        return v;
+    }();
+    return values;
+}
+
+template <typename T>
+inline const std::vector<T> &floats()
+{
+    static const std::vector<T> values = []
+    {
+        std::mt19937_64 rng(42);
+        std::uniform_real_distribution<double> mantissa(1.0, 2.0);
+        std::vector<T> v(num_values);
+        for (auto &x : v)
+        {
+            x = static_cast<T>(std::ldexp(mantissa(rng), static_cast<int>(rng() % 80) - 40));
+            if (rng() & 1)
+                x = -x;
+        }
+        return v;
+    }();
+    return values;
+}
+
+inline const std::vector<std::string> &strings()
+{
+    static const std::vector<std::string> values = []
+    {
+        std::mt19937_64 rng(42);
+        std::vector<std::string> v(num_values);
+        for (auto &s : v)
+        {
+            s.resize(rng() % 33);
+            for (auto &c : s)
+                c = static_cast<char>('a' + rng() % 26);
+        }
+        return v;
+    }();
+    return values;
+}
+
+template <typename T>
+const T &next(const std::vector<T> &values, size_t &i)
+{
+    return values[i++ & (num_values - 1)];
+}
+
+} // bench
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef FORMATPP_BENCHMARK_PERF_COUNTERS_H_
+#define FORMATPP_BENCHMARK_PERF_COUNTERS_H_
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+/// @brief Hardware counters read with perf_event_open around each benchmark loop
+///
+/// Each counter is opened separately, so a CPU or kernel that lacks some of the events
+/// still reports the others. When none can be opened (no permission, a container,
+/// not Linux) the counters are simply not reported.
+class perf_counters
+{
+public:
+    enum : int { num_events = 5 };
+
+    static perf_counters &instance()
+    {
+        static perf_counters counters;
+        return counters;
+    }
+
+    /// @brief Opens the counters; returns false if none are available
+    bool open()
+    {
+#ifdef __linux__
+        static const struct
+        {
+            uint32_t type;
+            uint64_t config;
+        } events[num_events] = {
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1I | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                                  PERF_COUNT_HW_CACHE_RESULT_MISS << 16 },
+            { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                                  PERF_COUNT_HW_CACHE_RESULT_MISS << 16 },
+        };
+        for (int i = 0; i < num_events; i++)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[i].type;
+            attr.config = events[i].config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fds[i] >= 0)
+                available = true;
+        }
+#endif
+        if (!available)
+            std::fprintf(stderr, "Hardware performance counters are not available; not reporting them\n");
+        return available;
+    }
+
+    bool enabled() const { return available; }
+
+    void start()
+    {
+#ifdef __linux__
+        for (int fd : fds)
+        {
+            if (fd < 0)
+                continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    /// @brief Stops counting and stores the counts, divided by the number of iterations, in `state.counters`
+    void stop(benchmark::State &state)
+    {
+#ifdef __linux__
+        uint64_t values[num_events];
+        for (int i = 0; i < num_events; i++)
+        {
+            if (fds[i] >= 0)
+                ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+        for (int i = 0; i < num_events; i++)
+        {
+            if (fds[i] < 0 || !read_scaled(fds[i], values[i]))
+                continue;
+            state.counters[names()[i]] = benchmark::Counter(static_cast<double>(values[i]),
+                                                            benchmark::Counter::kAvgIterations);
+        }
+#else
+        (void)state;
+#endif
+    }
+
+    ~perf_counters()
+    {
+#ifdef __linux__
+        for (int fd : fds)
+        {
+            if (fd >= 0)
+                close(fd);
+        }
+#endif
+    }
+
+private:
+    perf_counters()
+    {
+        for (int &fd : fds)
+            fd = -1;
+    }
+
+    static const char *const *names()
+    {
+        static const char *const n[num_events] = { "cycles", "instructions", "branch_misses", "L1i_misses", "L1d_misses" };
+        return n;
+    }
+
+#ifdef __linux__
+    /// Scales the count up when the kernel had to multiplex the counters
+    static bool read_scaled(int fd, uint64_t &value)
+    {
+        uint64_t data[3];  // value, time enabled, time running
+        if (read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || !data[2])
+            return false;
+        value = data[2] < data[1] ? static_cast<uint64_t>(static_cast<double>(data[0]) * data[1] / data[2]) : data[0];
+        return true;
+    }
+#endif
+
+    int fds[num_events];
+    bool available = false;
+};
+
+} // bench
+
+#endif
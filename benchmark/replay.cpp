@@ -0,0 +1,180 @@
+#include <formatpp/format.h>
+#include <benchmark/benchmark.h>
+#include "harness.h"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <streambuf>
+#include <vector>
+
+// Replays calls recorded by a program built with FORMATPP_CAPTURE:
+//     benchmark_replay <capture file> [benchmark options]
+// Each iteration formats the next captured call, with its original argument types,
+// so the results reflect the captured mix of specifiers, types and values.
+
+using namespace formatpp;
+
+namespace {
+
+std::vector<capture::captured_call> calls;
+size_t total_bytes = 0;
+size_t max_bytes = 0;
+
+/// Discards its input, so that the stream benchmarks don't measure a growing string
+class null_streambuf : public std::streambuf
+{
+protected:
+    int_type overflow(int_type c) override { return c; }
+    std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+};
+
+template <typename Context>
+std::vector<dynamic_format_params<Context>> make_params()
+{
+    std::vector<dynamic_format_params<Context>> params(calls.size());
+    for (size_t i = 0; i < calls.size(); i++)
+        capture::add_args(params[i], calls[i]);
+    return params;
+}
+
+/// Formats the captured calls to `Output` one per iteration, with the context created for each call, as in `format_to`
+template <typename Output, typename Reset>
+void replay(benchmark::State &state, Output &out, Reset reset)
+{
+    using context = output_context<Output &>;
+    auto params = make_params<context>();
+    size_t i = 0;
+    bench::scope scope(state);
+    for (auto _ : state)
+    {
+        reset();
+        context ctx(out);
+        vformat(ctx, calls[i].format.c_str(), params[i]);
+        if (++i == calls.size())
+            i = 0;
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * total_bytes / calls.size());
+}
+
+void BM_Replay_string(benchmark::State &state)
+{
+    std::string out;
+    out.reserve(max_bytes);
+    replay(state, out, [&]() { out.clear(); });
+}
+
+void BM_Replay_char_buf(benchmark::State &state)
+{
+    std::unique_ptr<char[]> storage(new char[max_bytes + 1]);
+    char_buf<char> out;
+    replay(state, out, [&]() { out = char_buf<char>(storage.get(), max_bytes + 1); });
+}
+
+void BM_Replay_ostream(benchmark::State &state)
+{
+    null_streambuf buf;
+    std::ostream out(&buf);
+    replay(state, out, []() {});
+}
+
+void BM_Replay_buffered_sink(benchmark::State &state)
+{
+    null_streambuf buf;
+    std::ostream stream(&buf);
+    buffered_sink out(stream);
+    replay(state, out, []() {});
+}
+
+void BM_Replay_formatted_size(benchmark::State &state)
+{
+    counting_sink out;
+    replay(state, out, [&]() { out.count = 0; });
+}
+
+/// Keeps the calls that can be replayed: all the arguments were captured and the call doesn't throw
+void load(const char *path)
+{
+    size_t skipped = 0;
+    std::set<std::string> formats;
+    for (auto &call : capture::read(path))
+    {
+        if (!call.replayable())
+        {
+            skipped++;
+            continue;
+        }
+        std::string out;
+        try
+        {
+            output_context<std::string &> ctx(out);
+            dynamic_format_params<output_context<std::string &>> params;
+            capture::add_args(params, call);
+            vformat(ctx, call.format.c_str(), params);
+        }
+        catch (const std::exception &)
+        {
+            skipped++;
+            continue;
+        }
+        total_bytes += out.size();
+        max_bytes = std::max(max_bytes, out.size());
+        formats.insert(call.format);
+        calls.push_back(std::move(call));
+    }
+    std::fprintf(stderr, "Replaying %zu calls with %zu distinct format strings, %zu bytes of output; %zu calls skipped\n",
+                 calls.size(), formats.size(), total_bytes, skipped);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *path = nullptr;
+    int n = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!std::strcmp(argv[i], "--perf_counters"))
+            bench::perf_counters::instance().open();
+        else if (!path && argv[i][0] != '-')
+            path = argv[i];
+        else
+            argv[n++] = argv[i];
+    }
+    argc = n;
+
+    if (!path)
+    {
+        std::fprintf(stderr, "Usage: %s <capture file> [--perf_counters] [benchmark options]\n", argv[0]);
+        return 1;
+    }
+    try
+    {
+        load(path);
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    if (calls.empty())
+    {
+        std::fprintf(stderr, "No calls to replay\n");
+        return 1;
+    }
+
+    benchmark::RegisterBenchmark("BM_Replay_string", BM_Replay_string);
+    benchmark::RegisterBenchmark("BM_Replay_char_buf", BM_Replay_char_buf);
+    benchmark::RegisterBenchmark("BM_Replay_ostream", BM_Replay_ostream);
+    benchmark::RegisterBenchmark("BM_Replay_buffered_sink", BM_Replay_buffered_sink);
+    benchmark::RegisterBenchmark("BM_Replay_formatted_size", BM_Replay_formatted_size);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
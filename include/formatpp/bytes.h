@@ -0,0 +1,191 @@
+#ifndef FORMATPP_BYTES_H_
+#define FORMATPP_BYTES_H_
+
+#include "format.h"
+#include "simd.h"
+#include <cstdint>
+
+namespace formatpp {
+
+/// @brief A non-owning view of raw bytes, formatted as hex
+struct byte_span
+{
+    byte_span() = default;
+    byte_span(const void *data, size_t size)
+    : data(static_cast<const uint8_t *>(data)), size(size)
+    {
+    }
+
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+};
+
+inline byte_span as_bytes(const void *data, size_t size)
+{
+    return { data, size };
+}
+
+/// @brief Views the contents of a contiguous container (std::string, std::vector, std::array) as bytes
+template <typename Container>
+byte_span as_bytes(const Container &c)
+{
+    return { c.data(), c.size() * sizeof(*c.data()) };
+}
+
+/// @brief Options for formatting byte spans
+///
+/// Syntax: `[x|X][group][d]`
+/// - `x`, `X` - lowercase (default) or uppercase digits
+/// - `group` - number of bytes per space-separated group, e.g. `{:x4}` prints `deadbeef 00010203`
+/// - `d` - `hexdump -C` layout: offsets, 16 bytes per line and a printable ASCII column
+struct byte_format_options
+{
+    void parse(const char *options, size_t &i)
+    {
+        switch (options[i])
+        {
+        case 'x':
+            digits = integer_format_options::lowercase_digits();
+            i++;
+            break;
+        case 'X':
+            digits = integer_format_options::uppercase_digits();
+            i++;
+            break;
+        }
+
+        char c;
+        while (is_ascii_digit(c = options[i]))
+        {
+            group = 10*group + (c - '0');
+            i++;
+        }
+
+        switch (options[i])
+        {
+        case 'd':
+            dump = true;
+            i++;
+            break;
+        case '}':
+        case '\0':
+            break;
+        default:
+            FORMATPP_FAIL(invalid_specifier, std::runtime_error(std::string("Invalid format specifier for bytes: ") + options));
+        }
+    }
+
+    const char *digits = integer_format_options::lowercase_digits();
+    size_t group = 0;
+    bool dump = false;
+};
+
+template <>
+struct default_format_options<byte_span, void> : byte_format_options
+{};
+
+template <>
+struct formatter<byte_span>
+{
+    template <typename Context>
+    static void format(Context &ctx, const byte_span &value, const format_options<byte_span> &options)
+    {
+        if (options.dump)
+            format_dump(ctx, value, options.digits);
+        else if (options.group)
+            format_grouped(ctx, value, options.digits, options.group);
+        else
+            format_plain(ctx, value, options.digits);
+    }
+
+private:
+    enum : size_t { chunk = 128 };
+
+    template <typename Context>
+    static void format_plain(Context &ctx, const byte_span &value, const char *digits)
+    {
+        char buf[2*chunk];
+        for (size_t i = 0; i < value.size; i += chunk)
+        {
+            size_t n = detail::min<size_t>(chunk, value.size - i);
+            simd::hex_encode(buf, value.data + i, n, digits);
+            write(ctx.out(), buf, 2*n);
+        }
+    }
+
+    template <typename Context>
+    static void format_grouped(Context &ctx, const byte_span &value, const char *digits, size_t group)
+    {
+        char hex[2*chunk];
+        char buf[3*chunk];
+        size_t in_group = 0;
+        for (size_t i = 0; i < value.size; i += chunk)
+        {
+            size_t n = detail::min<size_t>(chunk, value.size - i);
+            simd::hex_encode(hex, value.data + i, n, digits);
+            size_t len = 0;
+            for (size_t j = 0; j < n; j++)
+            {
+                if (in_group == group)
+                {
+                    buf[len++] = ' ';
+                    in_group = 0;
+                }
+                buf[len++] = hex[2*j];
+                buf[len++] = hex[2*j + 1];
+                in_group++;
+            }
+            write(ctx.out(), buf, len);
+        }
+    }
+
+    static void encode_offset(char *dst, size_t offset, const char *digits)
+    {
+        uint8_t be[4] = {
+            static_cast<uint8_t>(offset >> 24), static_cast<uint8_t>(offset >> 16),
+            static_cast<uint8_t>(offset >> 8), static_cast<uint8_t>(offset)
+        };
+        simd::hex_encode(dst, be, 4, digits);
+    }
+
+    template <typename Context>
+    static void format_dump(Context &ctx, const byte_span &value, const char *digits)
+    {
+        // 00000000  48 65 6c 6c 6f 2c 20 57  6f 72 6c 64 21 0a 00 01  |Hello, World!...|
+        constexpr size_t ascii_column = 8 + 2 + 16*3 + 1 + 1;
+        char hex[32];
+        char line[ascii_column + 16 + 3];
+        for (size_t offset = 0; offset < value.size; offset += 16)
+        {
+            size_t n = detail::min<size_t>(16, value.size - offset);
+            const uint8_t *bytes = value.data + offset;
+            simd::hex_encode(hex, bytes, n, digits);
+            encode_offset(line, offset, digits);
+            std::memset(line + 8, ' ', ascii_column - 8);
+            char *p = line + 10;
+            for (size_t j = 0; j < n; j++)
+            {
+                p[0] = hex[2*j];
+                p[1] = hex[2*j + 1];
+                p += j == 7 ? 4 : 3;
+            }
+            p = line + ascii_column;
+            *p++ = '|';
+            for (size_t j = 0; j < n; j++)
+                *p++ = bytes[j] >= 0x20 && bytes[j] < 0x7f ? static_cast<char>(bytes[j]) : '.';
+            *p++ = '|';
+            *p++ = '\n';
+            write(ctx.out(), line, p - line);
+        }
+        if (value.size)
+        {
+            encode_offset(line, value.size, digits);
+            line[8] = '\n';
+            write(ctx.out(), line, 9);
+        }
+    }
+};
+
+} // formatpp
+
+#endif
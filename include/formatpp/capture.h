@@ -0,0 +1,632 @@
+#ifndef FORMATPP_CAPTURE_H_
+#define FORMATPP_CAPTURE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "error.h"
+
+#ifdef FORMATPP_CAPTURE
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+#endif
+
+namespace formatpp {
+
+template <typename Char>
+class char_buf;
+
+template <typename Context>
+class dynamic_format_params;
+
+/// @brief Recording of format calls (format string, argument types and values) for replaying them in benchmarks
+///
+/// The file starts with `capture::magic` and is followed by records:
+/// - `F` id length text - defines a format string
+/// - `C` id count (type value)... - a call with the format string `id`
+///
+/// Numbers are LEB128 varints (signed ones zigzag-encoded), floats their little-endian IEEE bits.
+/// A format string may be defined after the calls that use it.
+namespace capture {
+
+static const char magic[8] = { 'F', 'P', 'P', 'C', 'A', 'P', '1', '\n' };
+
+enum class arg_type : uint8_t
+{
+    /// An argument of a type that can't be captured; calls with such arguments can't be replayed
+    other,
+    boolean,
+    character,
+    int8, int16, int32, int64,
+    uint8, uint16, uint32, uint64,
+    float32, float64,
+    /// Captured with double precision
+    long_double,
+    /// `std::string` or `char_buf`
+    string,
+    /// `const char *`, `char *` or a character array
+    c_string,
+    num_types
+};
+
+struct captured_arg
+{
+    arg_type type = arg_type::other;
+    /// Integers, characters and booleans
+    int64_t i = 0;
+    uint64_t u = 0;
+    double f = 0;
+    std::string str;
+};
+
+struct captured_call
+{
+    std::string format;
+    std::vector<captured_arg> args;
+
+    bool replayable() const noexcept
+    {
+        for (const captured_arg &a : args)
+            if (a.type == arg_type::other)
+                return false;
+        return true;
+    }
+};
+
+namespace detail {
+
+inline void put_varint(std::string &out, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        out += static_cast<char>((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    out += static_cast<char>(v);
+}
+
+inline void put_bits(std::string &out, uint64_t bits, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        out += static_cast<char>((bits >> (8 * i)) & 0xff);
+}
+
+inline uint64_t zigzag(int64_t v)
+{
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t unzigzag(uint64_t v)
+{
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+class reader
+{
+public:
+    reader(const char *data, size_t size) : p(data), end(data + size) {}
+
+    bool done() const noexcept { return p == end; }
+
+    uint8_t byte()
+    {
+        if (p == end)
+            FORMATPP_FAIL_RETURN(invalid_input, std::runtime_error("Truncated capture file"), 0);
+        return static_cast<uint8_t>(*p++);
+    }
+
+    uint64_t varint()
+    {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t b = byte();
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return v;
+        }
+        FORMATPP_FAIL_RETURN(invalid_input, std::runtime_error("Invalid number in a capture file"), 0);
+    }
+
+    uint64_t bits(int bytes)
+    {
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++)
+            v |= static_cast<uint64_t>(byte()) << (8 * i);
+        return v;
+    }
+
+    std::string text()
+    {
+        uint64_t len = varint();
+        if (len > static_cast<uint64_t>(end - p))
+            FORMATPP_FAIL_RETURN(invalid_input, std::runtime_error("Truncated capture file"), {});
+        std::string s(p, static_cast<size_t>(len));
+        p += len;
+        return s;
+    }
+
+private:
+    const char *p, *end;
+};
+
+inline captured_arg read_arg(reader &r)
+{
+    captured_arg a;
+    uint8_t type = r.byte();
+    if (type >= static_cast<uint8_t>(arg_type::num_types))
+        FORMATPP_FAIL_RETURN(invalid_input, std::runtime_error("Invalid argument type in a capture file"), a);
+    a.type = static_cast<arg_type>(type);
+    switch (a.type)
+    {
+    case arg_type::other:
+        break;
+    case arg_type::boolean:
+    case arg_type::character:
+    case arg_type::uint8:
+    case arg_type::uint16:
+    case arg_type::uint32:
+    case arg_type::uint64:
+        a.u = r.varint();
+        a.i = static_cast<int64_t>(a.u);
+        break;
+    case arg_type::int8:
+    case arg_type::int16:
+    case arg_type::int32:
+    case arg_type::int64:
+        a.i = unzigzag(r.varint());
+        a.u = static_cast<uint64_t>(a.i);
+        break;
+    case arg_type::float32:
+        {
+            uint32_t bits = static_cast<uint32_t>(r.bits(4));
+            float f;
+            std::memcpy(&f, &bits, 4);
+            a.f = f;
+        }
+        break;
+    case arg_type::float64:
+    case arg_type::long_double:
+        {
+            uint64_t bits = r.bits(8);
+            std::memcpy(&a.f, &bits, 8);
+        }
+        break;
+    case arg_type::string:
+    case arg_type::c_string:
+        a.str = r.text();
+        break;
+    default:
+        break;
+    }
+    return a;
+}
+
+} // detail
+
+/// @brief Parses the contents of a capture file
+/// @throws std::runtime_error if the data is malformed; without exceptions, returns no calls
+///         and reports `format_errc::invalid_input`
+inline std::vector<captured_call> parse(const char *data, size_t size)
+{
+    formatpp::detail::clear_error();
+    if (size < sizeof(magic) || std::memcmp(data, magic, sizeof(magic)))
+        FORMATPP_FAIL_RETURN(invalid_input, std::runtime_error("Not a format++ capture file"), {});
+    detail::reader r(data + sizeof(magic), size - sizeof(magic));
+
+    std::vector<std::string> formats;
+    std::vector<uint64_t> format_ids;
+    std::vector<captured_call> calls;
+    while (!r.done())
+    {
+        char tag = static_cast<char>(r.byte());
+        if (tag == 'F')
+        {
+            uint64_t id = r.varint();
+            if (id >= (1u << 24))
+                FORMATPP_FAIL_RETURN(invalid_input, std::runtime_error("Invalid format string id in a capture file"), {});
+            if (id >= formats.size())
+                formats.resize(id + 1);
+            formats[id] = r.text();
+        }
+        else if (tag == 'C')
+        {
+            format_ids.push_back(r.varint());
+            captured_call call;
+            uint64_t n = r.varint();
+            for (uint64_t i = 0; i < n && !formatpp::detail::failed(); i++)
+                call.args.push_back(detail::read_arg(r));
+            calls.push_back(std::move(call));
+        }
+        else
+            FORMATPP_FAIL_RETURN(invalid_input, std::runtime_error("Invalid record in a capture file"), {});
+        if (formatpp::detail::failed())
+            return {};
+    }
+    for (size_t i = 0; i < calls.size(); i++)
+    {
+        if (format_ids[i] >= formats.size())
+            FORMATPP_FAIL_RETURN(invalid_input, std::runtime_error("Undefined format string in a capture file"), {});
+        calls[i].format = formats[format_ids[i]];
+    }
+    return calls;
+}
+
+/// @brief Reads a capture file
+/// @throws std::runtime_error if the file can't be read or is malformed
+inline std::vector<captured_call> read(const char *path)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f)
+        FORMATPP_FAIL_RETURN(invalid_input, std::runtime_error(std::string("Cannot open ") + path), {});
+    std::string data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    return parse(data.data(), data.size());
+}
+
+/// @brief Adds the arguments of a captured call, with their original types, to `params`
+///
+/// C strings point into `call`, which must outlive `params`.
+/// @throws std::logic_error if the call has arguments that were not captured
+template <typename Context>
+void add_args(dynamic_format_params<Context> &params, const captured_call &call)
+{
+    for (const captured_arg &a : call.args)
+    {
+        switch (a.type)
+        {
+        case arg_type::boolean:     params.template push_back<bool>(a.u != 0); break;
+        case arg_type::character:   params.template push_back<char>(static_cast<char>(a.u)); break;
+        case arg_type::int8:        params.template push_back<int8_t>(static_cast<int8_t>(a.i)); break;
+        case arg_type::int16:       params.template push_back<int16_t>(static_cast<int16_t>(a.i)); break;
+        case arg_type::int32:       params.template push_back<int32_t>(static_cast<int32_t>(a.i)); break;
+        case arg_type::int64:       params.template push_back<int64_t>(a.i); break;
+        case arg_type::uint8:       params.template push_back<uint8_t>(static_cast<uint8_t>(a.u)); break;
+        case arg_type::uint16:      params.template push_back<uint16_t>(static_cast<uint16_t>(a.u)); break;
+        case arg_type::uint32:      params.template push_back<uint32_t>(static_cast<uint32_t>(a.u)); break;
+        case arg_type::uint64:      params.template push_back<uint64_t>(a.u); break;
+        case arg_type::float32:     params.template push_back<float>(static_cast<float>(a.f)); break;
+        case arg_type::float64:     params.template push_back<double>(a.f); break;
+        case arg_type::long_double: params.template push_back<long double>(a.f); break;
+        case arg_type::string:      params.template push_back<std::string>(a.str); break;
+        case arg_type::c_string:    params.template push_back<const char *>(a.str.c_str()); break;
+        default:
+            FORMATPP_FAIL(invalid_argument, std::logic_error("The call has an argument that was not captured"));
+        }
+    }
+}
+
+#ifdef FORMATPP_CAPTURE
+
+constexpr bool enabled = true;
+
+namespace detail {
+
+template <typename T>
+using enable_if_int_t = typename std::enable_if<std::is_integral<T>::value &&
+    !std::is_same<T, bool>::value && !std::is_same<T, char>::value>::type;
+
+template <typename T>
+enable_if_int_t<T> encode(std::string &out, const T &value)
+{
+    static const arg_type signed_types[] = { arg_type::int8, arg_type::int16, arg_type::int32, arg_type::int64 };
+    static const arg_type unsigned_types[] = { arg_type::uint8, arg_type::uint16, arg_type::uint32, arg_type::uint64 };
+    int size_index = sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1 : sizeof(T) == 4 ? 2 : 3;
+    if (std::is_signed<T>::value)
+    {
+        out += static_cast<char>(signed_types[size_index]);
+        put_varint(out, zigzag(static_cast<int64_t>(value)));
+    }
+    else
+    {
+        out += static_cast<char>(unsigned_types[size_index]);
+        put_varint(out, static_cast<uint64_t>(value));
+    }
+}
+
+inline void encode(std::string &out, bool value)
+{
+    out += static_cast<char>(arg_type::boolean);
+    put_varint(out, value);
+}
+
+inline void encode(std::string &out, char value)
+{
+    out += static_cast<char>(arg_type::character);
+    put_varint(out, static_cast<unsigned char>(value));
+}
+
+inline void encode(std::string &out, float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    out += static_cast<char>(arg_type::float32);
+    put_bits(out, bits, 4);
+}
+
+inline void encode_double(std::string &out, arg_type type, double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, 8);
+    out += static_cast<char>(type);
+    put_bits(out, bits, 8);
+}
+
+inline void encode(std::string &out, double value)
+{
+    encode_double(out, arg_type::float64, value);
+}
+
+inline void encode(std::string &out, long double value)
+{
+    encode_double(out, arg_type::long_double, static_cast<double>(value));
+}
+
+inline void encode_text(std::string &out, arg_type type, const char *str, size_t len)
+{
+    out += static_cast<char>(type);
+    put_varint(out, len);
+    out.append(str, len);
+}
+
+inline void encode(std::string &out, const char *value)
+{
+    encode_text(out, arg_type::c_string, value, std::strlen(value));
+}
+
+inline void encode(std::string &out, char *value)
+{
+    encode(out, const_cast<const char *>(value));
+}
+
+inline void encode(std::string &out, const std::string &value)
+{
+    encode_text(out, arg_type::string, value.data(), value.size());
+}
+
+template <typename Char>
+typename std::enable_if<sizeof(Char) == 1>::type encode(std::string &out, const char_buf<Char> &value)
+{
+    encode_text(out, arg_type::string, value.data(), value.size());
+}
+
+template <typename T>
+auto encode_arg(std::string &out, const T &value, int) -> decltype(encode(out, value))
+{
+    encode(out, value);
+}
+
+template <typename T>
+void encode_arg(std::string &out, const T &, long)
+{
+    out += static_cast<char>(arg_type::other);
+}
+
+struct thread_buffer;
+
+/// The capture file and the buffers of all threads
+struct recorder
+{
+    std::mutex lock;
+    std::FILE *file = nullptr;
+    std::atomic<bool> active;
+    /// Bumped by `start`, so that the threads forget the format string ids of the previous file
+    std::atomic<uint64_t> generation;
+    std::atomic<uint32_t> next_id;
+    std::atomic<uint32_t> sample_every;
+    thread_buffer *threads = nullptr;
+
+    recorder() : active(false), generation(0), next_id(0), sample_every(1)
+    {
+        if (const char *path = std::getenv("FORMATPP_CAPTURE_FILE"))
+            open(path, 1);
+    }
+
+    ~recorder();
+
+    static recorder &instance()
+    {
+        static recorder r;
+        return r;
+    }
+
+    /// The lock must be held
+    bool open(const char *path, uint32_t sample);
+    void close();
+
+    void write(const std::string &chunk)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (file && !chunk.empty())
+            std::fwrite(chunk.data(), 1, chunk.size(), file);
+    }
+};
+
+/// @brief Records of one thread; they are written to the file in chunks, without holding the buffer's lock
+struct thread_buffer
+{
+    enum : size_t { flush_threshold = 1 << 16 };
+
+    std::mutex lock;
+    std::string data;
+    /// Format strings by address, with their text: a reused buffer can hold a different one
+    std::unordered_map<const char *, std::pair<uint32_t, std::string>> ids;
+    uint64_t generation = 0;
+    uint32_t countdown = 0;
+    thread_buffer *prev = nullptr, *next = nullptr;
+
+    thread_buffer()
+    {
+        recorder &r = recorder::instance();
+        std::lock_guard<std::mutex> guard(r.lock);
+        next = r.threads;
+        if (next)
+            next->prev = this;
+        r.threads = this;
+    }
+
+    ~thread_buffer()
+    {
+        recorder &r = recorder::instance();
+        std::string chunk = take();
+        std::lock_guard<std::mutex> guard(r.lock);
+        if (r.file && !chunk.empty())
+            std::fwrite(chunk.data(), 1, chunk.size(), r.file);
+        if (prev)
+            prev->next = next;
+        else
+            r.threads = next;
+        if (next)
+            next->prev = prev;
+    }
+
+    std::string take()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        std::string chunk;
+        chunk.swap(data);
+        return chunk;
+    }
+
+    /// The same address with a different text is a different (dynamically built) format string
+    uint32_t format_id(const char *format, size_t len)
+    {
+        auto it = ids.find(format);
+        if (it != ids.end() && it->second.second.size() == len && std::memcmp(it->second.second.data(), format, len) == 0)
+            return it->second.first;
+        uint32_t id = recorder::instance().next_id.fetch_add(1, std::memory_order_relaxed);
+        ids[format] = { id, std::string(format, len) };
+        data += 'F';
+        put_varint(data, id);
+        put_varint(data, len);
+        data.append(format, len);
+        return id;
+    }
+};
+
+inline bool recorder::open(const char *path, uint32_t sample)
+{
+    close();
+    file = std::fopen(path, "wb");
+    if (!file)
+        return false;
+    std::fwrite(magic, 1, sizeof(magic), file);
+    sample_every.store(sample ? sample : 1, std::memory_order_relaxed);
+    next_id.store(0, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+    active.store(true, std::memory_order_release);
+    return true;
+}
+
+inline void recorder::close()
+{
+    active.store(false, std::memory_order_release);
+    for (thread_buffer *t = threads; t; t = t->next)
+    {
+        std::string chunk = t->take();
+        if (file && !chunk.empty())
+            std::fwrite(chunk.data(), 1, chunk.size(), file);
+    }
+    if (file)
+    {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+inline recorder::~recorder()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    close();
+}
+
+inline thread_buffer &this_thread()
+{
+    static thread_local thread_buffer buffer;
+    return buffer;
+}
+
+template <typename... Args>
+void record(const char *format, size_t len, const Args &... args)
+{
+    recorder &r = recorder::instance();
+    if (!r.active.load(std::memory_order_relaxed))
+        return;
+    thread_buffer &t = this_thread();
+    std::unique_lock<std::mutex> guard(t.lock);
+    uint64_t generation = r.generation.load(std::memory_order_acquire);
+    if (t.generation != generation)
+    {
+        t.ids.clear();
+        t.data.clear();
+        t.countdown = 0;
+        t.generation = generation;
+    }
+    if (t.countdown)
+    {
+        t.countdown--;
+        return;
+    }
+    t.countdown = r.sample_every.load(std::memory_order_relaxed) - 1;
+
+    uint32_t id = t.format_id(format, len);
+    t.data += 'C';
+    put_varint(t.data, id);
+    put_varint(t.data, sizeof...(Args));
+    int expand[] = { 0, (encode_arg<typename std::decay<const Args>::type>(t.data, args, 0), 0)... };
+    (void)expand;
+
+    if (t.data.size() >= thread_buffer::flush_threshold)
+    {
+        std::string chunk;
+        chunk.swap(t.data);
+        guard.unlock();
+        r.write(chunk);
+    }
+}
+
+} // detail
+
+/// @brief Starts recording the calls to `format_to` into a new file, replacing the current one
+///
+/// Only every `sample_every`-th call of each thread is recorded. Capturing starts automatically
+/// if the `FORMATPP_CAPTURE_FILE` environment variable names a file.
+/// @return false if the file can't be created
+inline bool start(const char *path, uint32_t sample_every = 1)
+{
+    detail::recorder &r = detail::recorder::instance();
+    std::lock_guard<std::mutex> guard(r.lock);
+    return r.open(path, sample_every);
+}
+
+/// @brief Stops recording and writes the calls buffered by all threads to the file
+inline void stop()
+{
+    detail::recorder &r = detail::recorder::instance();
+    std::lock_guard<std::mutex> guard(r.lock);
+    r.close();
+}
+
+#define FORMATPP_CAPTURE_CALL(format, len, args) FORMATPP_RUNTIME_ONLY(::formatpp::capture::detail::record(format, len, args))
+
+#else
+
+constexpr bool enabled = false;
+
+#define FORMATPP_CAPTURE_CALL(format, len, args) ((void)0)
+
+#endif
+
+} // capture
+
+} // formatpp
+
+#endif
@@ -0,0 +1,504 @@
+#ifndef FORMATPP_CHRONO_H_
+#define FORMATPP_CHRONO_H_
+
+#include "format.h"
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
+namespace formatpp {
+namespace detail {
+
+inline bool to_tm(std::time_t t, bool utc, std::tm &out)
+{
+#ifdef _WIN32
+    return (utc ? gmtime_s(&out, &t) : localtime_s(&out, &t)) == 0;
+#else
+    return (utc ? gmtime_r(&t, &out) : localtime_r(&t, &out)) != nullptr;
+#endif
+}
+
+inline int64_t floor_div(int64_t a, int64_t b)
+{
+    int64_t q = a / b;
+    return (a % b < 0) ? q - 1 : q;
+}
+
+constexpr uint32_t pow10_u32[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+/// @brief A timestamp rendered with strftime for one minute (or second), with slots
+///        for the fields which change more often
+///
+/// Seconds (`%S`) and fractions of a second (`%f`, `%3f`, `%6f`, `%9f`) are not rendered;
+/// instead, their positions are recorded and the digits are written at formatting time.
+struct timestamp_cache_entry
+{
+    static constexpr size_t max_spec = 64;
+    static constexpr size_t max_text = 128;
+    static constexpr int max_slots = 4;
+
+    struct slot
+    {
+        uint16_t offset;
+        /// number of digits; 2 for seconds, 1-9 for fractions of a second
+        uint8_t digits;
+        bool is_seconds;
+    };
+
+    char spec[max_spec];
+    size_t spec_len = 0;
+    bool utc = false;
+    bool per_second = false;
+    int64_t key = INT64_MIN;
+
+    char text[max_text];
+    size_t text_len = 0;
+    slot slots[max_slots];
+    int num_slots = 0;
+
+    bool matches(const char *s, size_t len, bool is_utc) const
+    {
+        return len == spec_len && is_utc == utc && !std::memcmp(s, spec, len);
+    }
+
+    void set_spec(const char *s, size_t len, bool is_utc)
+    {
+        std::memcpy(spec, s, len);
+        spec_len = len;
+        utc = is_utc;
+        key = INT64_MIN;
+        per_second = false;
+        for (size_t i = 0; i + 1 < len; i++)
+        {
+            if (s[i] != '%')
+                continue;
+            // The E and O modifiers select alternative representations of the same field
+            if ((s[i + 1] == 'E' || s[i + 1] == 'O') && i + 2 < len)
+                i++;
+            switch (s[++i])
+            {
+            case 's':
+            case 'c':
+            case 'r':
+            case 'T':
+            case 'X':
+            case '+':
+                per_second = true;
+                break;
+            }
+        }
+    }
+
+    void render(int64_t seconds)
+    {
+        int64_t new_key = per_second ? seconds : floor_div(seconds, 60);
+        if (new_key == key)
+            return;
+
+        std::tm tm;
+        std::time_t t = static_cast<std::time_t>(per_second ? seconds : new_key * 60);
+        if (!to_tm(t, utc, tm))
+            FORMATPP_FAIL(invalid_value, std::runtime_error("Cannot convert time point to calendar time"));
+
+        char chunk[max_spec + 1];
+        size_t chunk_len = 0;
+        text_len = 0;
+        num_slots = 0;
+        auto flush_chunk = [&]()
+        {
+            if (!chunk_len)
+                return;
+            chunk[chunk_len] = 0;
+            size_t n = std::strftime(text + text_len, max_text - text_len, chunk, &tm);
+            if (!n)
+                FORMATPP_FAIL(invalid_value, std::runtime_error("Formatted timestamp too long"));
+            text_len += n;
+            chunk_len = 0;
+        };
+        auto add_slot = [&](int digits, bool is_seconds)
+        {
+            flush_chunk();
+            if (num_slots == max_slots)
+                FORMATPP_FAIL(invalid_specifier, std::runtime_error("Too many second fields in a timestamp format"));
+            slots[num_slots++] = { static_cast<uint16_t>(text_len), static_cast<uint8_t>(digits), is_seconds };
+        };
+
+        for (size_t i = 0; i < spec_len; i++)
+        {
+            if (spec[i] == '%' && i + 1 < spec_len)
+            {
+                char c = spec[i + 1];
+                if (c == 'S' && !per_second)
+                {
+                    add_slot(2, true);
+                    i++;
+                    continue;
+                }
+                if ((c == 'E' || c == 'O') && i + 2 < spec_len && spec[i + 2] == 'S' && !per_second)
+                {
+                    add_slot(2, true);
+                    i += 2;
+                    continue;
+                }
+                if (c == 'f')
+                {
+                    add_slot(6, false);
+                    i++;
+                    continue;
+                }
+                if (c >= '1' && c <= '9' && i + 2 < spec_len && spec[i + 2] == 'f')
+                {
+                    add_slot(c - '0', false);
+                    i += 2;
+                    continue;
+                }
+                chunk[chunk_len++] = spec[i++];
+            }
+            chunk[chunk_len++] = spec[i];
+        }
+        flush_chunk();
+        if (failed())
+            return;
+        key = new_key;
+    }
+
+    size_t length() const
+    {
+        size_t n = text_len;
+        for (int i = 0; i < num_slots; i++)
+            n += slots[i].digits;
+        return n;
+    }
+};
+
+/// @brief Returns the calling thread's cache entry for the given timestamp format
+inline timestamp_cache_entry &timestamp_cache(const char *spec, size_t len, bool utc)
+{
+    static constexpr int cache_size = 4;
+    static thread_local timestamp_cache_entry entries[cache_size];
+    static thread_local int next_victim = 0;
+
+    for (auto &e : entries)
+        if (e.matches(spec, len, utc))
+            return e;
+
+    auto &e = entries[next_victim];
+    next_victim = (next_victim + 1) % cache_size;
+    e.set_spec(spec, len, utc);
+    return e;
+}
+
+} // detail
+
+/// @brief Options for formatting `std::chrono::system_clock` time points
+///
+/// The specifier uses `strftime` conversions, with the following additions:
+/// - `%f` - microseconds, `%3f`, `%6f`, `%9f` (or any other digit) - fraction of a second
+/// - a leading `!` selects UTC instead of local time
+/// An optional fill, alignment and width may precede the conversions: `{:*<30%H:%M}`.
+struct timestamp_format_options : align_options
+{
+    void parse(const char *options, size_t &i)
+    {
+        parse_align(options, i);
+        char c;
+        while (is_ascii_digit(c = options[i]))
+        {
+            width = 10*width + (c - '0');
+            i++;
+        }
+        if (options[i] == '!')
+        {
+            utc = true;
+            i++;
+        }
+        size_t start = i;
+        while (options[i] && options[i] != '}')
+            i++;
+        if (i - start >= sizeof(spec))
+            FORMATPP_FAIL(invalid_specifier, std::runtime_error(std::string("Timestamp format specifier too long: ") + options));
+        if (i > start)
+        {
+            std::memcpy(spec, options + start, i - start);
+            spec_len = i - start;
+        }
+    }
+
+    int width = 0;
+    bool utc = false;
+    char spec[detail::timestamp_cache_entry::max_spec] = "%Y-%m-%d %H:%M:%S";
+    size_t spec_len = 17;
+};
+
+/// @brief Options for formatting durations
+///
+/// Syntax: `[[fill]align][width][.precision][ns|us|ms|s]`, e.g. `{:.3ms}` prints `1.500ms` for 1500us.
+/// Without a unit, the count is printed in the duration's own unit.
+struct duration_format_options : align_options
+{
+    enum class unit : uint8_t { native, ns, us, ms, s };
+
+    void parse(const char *options, size_t &i)
+    {
+        parse_align(options, i);
+        char c;
+        while (is_ascii_digit(c = options[i]))
+        {
+            width = 10*width + (c - '0');
+            i++;
+        }
+        if (c == '.')
+        {
+            i++;
+            precision = 0;
+            while (is_ascii_digit(c = options[i]))
+            {
+                precision = 10*precision + (c - '0');
+                i++;
+            }
+        }
+        switch (options[i])
+        {
+        case 'n':
+            to_unit = unit::ns;
+            break;
+        case 'u':
+            to_unit = unit::us;
+            break;
+        case 'm':
+            to_unit = unit::ms;
+            break;
+        case 's':
+            to_unit = unit::s;
+            return;
+        case '}':
+        case '\0':
+            return;
+        default:
+            FORMATPP_FAIL(invalid_specifier, std::runtime_error(std::string("Invalid format specifier for a duration: ") + options));
+        }
+        if (options[++i] != 's')
+            FORMATPP_FAIL(invalid_specifier, std::runtime_error(std::string("Invalid format specifier for a duration: ") + options));
+    }
+
+    int width = 0;
+    int precision = -1;
+    unit to_unit = unit::native;
+};
+
+template <typename Duration>
+struct default_format_options<std::chrono::time_point<std::chrono::system_clock, Duration>, void>
+: timestamp_format_options
+{};
+
+template <typename Rep, typename Period>
+struct default_format_options<std::chrono::duration<Rep, Period>, void>
+: duration_format_options
+{};
+
+/// @brief Formats wall-clock time points
+///
+/// The calendar part is rendered with `strftime` at most once per minute (or per second,
+/// if the format contains conversions such as `%c` or `%T`), per thread and format;
+/// seconds and fractions are written into the cached text with the integer formatter.
+template <typename Duration>
+struct formatter<std::chrono::time_point<std::chrono::system_clock, Duration>>
+{
+    using time_point = std::chrono::time_point<std::chrono::system_clock, Duration>;
+
+    template <typename Context>
+    static void format(Context &ctx, const time_point &value, const format_options<time_point> &options)
+    {
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(value.time_since_epoch()).count();
+        int64_t seconds = detail::floor_div(ns, 1000000000);
+        uint32_t fraction = static_cast<uint32_t>(ns - seconds * 1000000000);
+
+        auto &cache = detail::timestamp_cache(options.spec, options.spec_len, options.utc);
+        cache.render(seconds);
+        if (detail::failed())
+            return;
+
+        auto pad = detail::compute_padding(options, options.width, cache.length());
+        put_fill(ctx.out(), pad.before, options.fill);
+
+        format_options<uint32_t> digit_options;
+        size_t pos = 0;
+        for (int i = 0; i < cache.num_slots; i++)
+        {
+            const auto &slot = cache.slots[i];
+            write(ctx.out(), cache.text + pos, slot.offset - pos);
+            pos = slot.offset;
+            digit_options.precision = slot.digits;
+            uint32_t digits = slot.is_seconds
+                ? static_cast<uint32_t>(seconds - detail::floor_div(seconds, 60) * 60)
+                : fraction / detail::pow10_u32[9 - slot.digits];
+            formatter<uint32_t>::format(ctx, digits, digit_options);
+        }
+        write(ctx.out(), cache.text + pos, cache.text_len - pos);
+        put_fill(ctx.out(), pad.after, options.fill);
+    }
+};
+
+template <typename Rep, typename Period>
+struct formatter<std::chrono::duration<Rep, Period>>
+{
+    using duration = std::chrono::duration<Rep, Period>;
+    using unit = duration_format_options::unit;
+
+    /// The width covers the count together with its unit suffix
+    template <typename Context>
+    static void format(Context &ctx, const duration &value, const format_options<duration> &options)
+    {
+        detail::padding pad = { 0, 0 };
+        if (options.width > 0)
+        {
+            counting_sink counter;
+            output_context<counting_sink &> mctx(counter);
+            format_count(mctx, value, options);
+            pad = detail::compute_padding(options, options.width, counter.count);
+        }
+        put_fill(ctx.out(), pad.before, options.fill);
+        format_count(ctx, value, options);
+        put_fill(ctx.out(), pad.after, options.fill);
+    }
+
+private:
+    template <typename Context>
+    static void format_count(Context &ctx, const duration &value, const format_options<duration> &options)
+    {
+        if (options.to_unit == unit::native)
+            format_native(ctx, value, options, std::is_floating_point<Rep>());
+        else
+            format_converted(ctx, value, options, std::is_floating_point<Rep>());
+    }
+
+    static const char *native_suffix()
+    {
+        using namespace std;
+        return is_same<Period, nano>::value  ? "ns"  :
+               is_same<Period, micro>::value ? "us"  :
+               is_same<Period, milli>::value ? "ms"  :
+               is_same<Period, ratio<1>>::value ? "s" :
+               is_same<Period, ratio<60>>::value ? "min" :
+               is_same<Period, ratio<3600>>::value ? "h" :
+               is_same<Period, ratio<86400>>::value ? "d" :
+               nullptr;
+    }
+
+    static const char *unit_suffix(unit u)
+    {
+        switch (u)
+        {
+        case unit::ns:
+            return "ns";
+        case unit::us:
+            return "us";
+        case unit::ms:
+            return "ms";
+        default:
+            return "s";
+        }
+    }
+
+    static int64_t unit_ns(unit u)
+    {
+        switch (u)
+        {
+        case unit::ns:
+            return 1;
+        case unit::us:
+            return 1000;
+        case unit::ms:
+            return 1000000;
+        default:
+            return 1000000000;
+        }
+    }
+
+    template <typename Context>
+    static void put_suffix(Context &ctx)
+    {
+        if (const char *suffix = native_suffix())
+        {
+            put(ctx.out(), suffix);
+        }
+        else
+        {
+            format_to(ctx, "[{}/{}]s", static_cast<intmax_t>(Period::num), static_cast<intmax_t>(Period::den));
+        }
+    }
+
+    template <typename Context>
+    static void format_native(Context &ctx, const duration &value, const format_options<duration> &options, std::false_type)
+    {
+        formatter<Rep>::format(ctx, value.count(), {});
+        put_suffix(ctx);
+    }
+
+    template <typename Context>
+    static void format_native(Context &ctx, const duration &value, const format_options<duration> &options, std::true_type)
+    {
+        format_options<Rep> count_options;
+        count_options.precision = options.precision;
+        if (options.precision >= 0)
+            count_options.fp_mode = fp_format_mode::positional;
+        formatter<Rep>::format(ctx, value.count(), count_options);
+        put_suffix(ctx);
+    }
+
+    template <typename Context>
+    static void format_converted(Context &ctx, const duration &value, const format_options<duration> &options, std::true_type)
+    {
+        format_options<double> count_options;
+        count_options.precision = options.precision;
+        if (options.precision >= 0)
+            count_options.fp_mode = fp_format_mode::positional;
+        double ns = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(value).count();
+        formatter<double>::format(ctx, ns / unit_ns(options.to_unit), count_options);
+        put(ctx.out(), unit_suffix(options.to_unit));
+    }
+
+    template <typename Context>
+    static void format_converted(Context &ctx, const duration &value, const format_options<duration> &options, std::false_type)
+    {
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(value).count();
+        int64_t unit_size = unit_ns(options.to_unit);
+        bool negative = ns < 0;
+        uint64_t magnitude = negative ? 0 - static_cast<uint64_t>(ns) : static_cast<uint64_t>(ns);
+        uint64_t whole = magnitude / unit_size;
+        uint64_t remainder = magnitude % unit_size;
+        // there are no digits beyond nanoseconds
+        int precision = detail::min(options.precision, 9);
+        uint64_t fraction = 0;
+        if (precision >= 0)
+        {
+            // round half to even, like floating-point counts
+            uint64_t scaled = remainder * detail::pow10_u32[precision];
+            fraction = scaled / unit_size;
+            uint64_t rest = 2 * (scaled % unit_size);
+            uint64_t last_digit = precision > 0 ? fraction : whole;
+            if (rest > static_cast<uint64_t>(unit_size) || (rest == static_cast<uint64_t>(unit_size) && (last_digit & 1)))
+                fraction++;
+            if (fraction == detail::pow10_u32[precision])
+            {
+                whole++;
+                fraction = 0;
+            }
+        }
+        if (negative)
+            put(ctx.out(), '-');
+        formatter<uint64_t>::format(ctx, whole, {});
+        if (precision > 0)
+        {
+            put(ctx.out(), '.');
+            format_options<uint64_t> fraction_options;
+            fraction_options.precision = precision;
+            formatter<uint64_t>::format(ctx, fraction, fraction_options);
+        }
+        put(ctx.out(), unit_suffix(options.to_unit));
+    }
+};
+
+} // formatpp
+
+#endif
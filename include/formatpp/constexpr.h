@@ -0,0 +1,40 @@
+#ifndef FORMATPP_CONSTEXPR_H_
+#define FORMATPP_CONSTEXPR_H_
+
+#include <type_traits>
+
+// C++20 (constexpr virtual functions, `try`, uninitialized variables and `std::is_constant_evaluated`)
+// lets the integer, bool, char and string formatters run in constant evaluation; in earlier standards
+// `FORMATPP_CONSTEXPR20` expands to nothing and formatting is run-time only.
+#if __cplusplus >= 202002L && defined(__cpp_lib_is_constant_evaluated) && defined(__cpp_constexpr) && __cpp_constexpr >= 201907L
+#define FORMATPP_CONSTEXPR_FORMAT 1
+#define FORMATPP_CONSTEXPR20 constexpr
+#else
+#define FORMATPP_CONSTEXPR_FORMAT 0
+#define FORMATPP_CONSTEXPR20
+#endif
+
+namespace formatpp {
+namespace detail {
+
+/// True while formatting in a constant expression; always false before C++20
+constexpr bool is_constant_evaluated() noexcept
+{
+#if FORMATPP_CONSTEXPR_FORMAT
+    return std::is_constant_evaluated();
+#else
+    return false;
+#endif
+}
+
+} // detail
+} // formatpp
+
+/// Evaluates `expr` (statistics, profiling, capture) only at run time
+#if FORMATPP_CONSTEXPR_FORMAT
+#define FORMATPP_RUNTIME_ONLY(expr) (::formatpp::detail::is_constant_evaluated() ? (void)0 : (void)(expr))
+#else
+#define FORMATPP_RUNTIME_ONLY(expr) ((void)(expr))
+#endif
+
+#endif
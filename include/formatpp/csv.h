@@ -0,0 +1,193 @@
+#ifndef FORMATPP_CSV_H_
+#define FORMATPP_CSV_H_
+
+#include "format.h"
+#include "simd.h"
+#include <initializer_list>
+
+namespace formatpp {
+
+struct csv_dialect
+{
+    char delimiter = ',';
+    char quote = '"';
+    /// RFC 4180 mandates CRLF line breaks
+    const char *line_break = "\r\n";
+
+    static csv_dialect csv() { return {}; }
+    static csv_dialect tsv()
+    {
+        csv_dialect d;
+        d.delimiter = '\t';
+        d.line_break = "\n";
+        return d;
+    }
+};
+
+/// @brief Writes a field, quoting it if it contains a delimiter, a quote or a line break
+///
+/// Quotes inside the field are doubled, as required by RFC 4180.
+template <typename Output>
+void write_csv_field(Output &out, const char *str, size_t len, const csv_dialect &dialect)
+{
+    const char *end = str + len;
+    const char *special = simd::find_any_of(str, end, dialect.delimiter, dialect.quote, '\n', '\r');
+    if (special == end)
+    {
+        write(out, str, len);
+        return;
+    }
+
+    write(out, &dialect.quote, 1);
+    write(out, str, special - str);
+    str = special;
+    for (;;)
+    {
+        const char *q = simd::find_char(str, end, dialect.quote);
+        if (q == end)
+            break;
+        // write up to and including the quote and then repeat it
+        write(out, str, q + 1 - str);
+        write(out, q, 1);
+        str = q + 1;
+    }
+    write(out, str, end - str);
+    write(out, &dialect.quote, 1);
+}
+
+template <typename T, typename Category = category<T>>
+struct csv_field_writer
+{
+    template <typename Context>
+    static void write_field(Context &ctx, const T &value, const format_options<T> &options, const csv_dialect &)
+    {
+        formatter<T>::format(ctx, value, options);
+    }
+};
+
+template <typename T>
+struct csv_field_writer<T, StringType>
+{
+    template <typename Context>
+    static void write_field(Context &ctx, const T &value, const format_options<T> &options, const csv_dialect &dialect)
+    {
+        size_t len = string_length(value);
+        if (options.precision >= 0 && static_cast<size_t>(options.precision) < len)
+            len = options.precision;
+        write_csv_field(ctx.out(), c_str(value), len, dialect);
+    }
+};
+
+template <typename T>
+struct csv_field_writer<T, CharType>
+{
+    template <typename Context>
+    static void write_field(Context &ctx, const T &value, const format_options<T> &, const csv_dialect &dialect)
+    {
+        char c = value;
+        write_csv_field(ctx.out(), &c, 1, dialect);
+    }
+};
+
+/// @brief Writes rows of a fixed column layout as CSV (or any other delimiter-separated values)
+///
+/// The column format specifiers are parsed once, at construction. Numbers are formatted with
+/// the regular formatters; strings are copied verbatim unless they need quoting.
+///
+/// Usage:
+/// ```
+/// buffered_sink sink(file);
+/// csv_writer<buffered_sink, int, double, std::string> csv(sink, { "", ".3f", "" });
+/// csv.write_row(1, 2.5, "a, b");    // 1,2.500,"a, b"
+/// ```
+template <typename Output, typename... Columns>
+class csv_writer
+{
+public:
+    static constexpr size_t num_columns = sizeof...(Columns);
+
+    explicit csv_writer(Output &out, const csv_dialect &dialect = {})
+    : ctx(out), dialect(dialect)
+    {
+    }
+
+    csv_writer(Output &out, std::initializer_list<const char *> specs, const csv_dialect &dialect = {})
+    : ctx(out), dialect(dialect)
+    {
+        if (specs.size() != num_columns)
+            FORMATPP_FAIL(invalid_argument, std::logic_error("Number of column format specifiers doesn't match the number of columns"));
+        parse_specs(specs.begin(), std::integral_constant<size_t, 0>());
+    }
+
+    void write_row(const Columns &... fields)
+    {
+        write_row(std::forward_as_tuple(fields...));
+    }
+
+    template <typename... Fields>
+    void write_row(const std::tuple<Fields...> &fields)
+    {
+        static_assert(sizeof...(Fields) == num_columns, "Number of fields doesn't match the number of columns");
+        write_fields(fields, std::integral_constant<size_t, 0>());
+        put(ctx.out(), dialect.line_break);
+    }
+
+    /// @brief Writes a header row; names are quoted when necessary
+    void write_header(std::initializer_list<const char *> names)
+    {
+        bool first = true;
+        for (const char *name : names)
+        {
+            if (!first)
+                write(ctx.out(), &dialect.delimiter, 1);
+            first = false;
+            write_csv_field(ctx.out(), name, string_length(name), dialect);
+        }
+        put(ctx.out(), dialect.line_break);
+    }
+
+    const csv_dialect &get_dialect() const noexcept { return dialect; }
+
+private:
+    using column_types = std::tuple<Columns...>;
+
+    template <size_t index>
+    using column_type = typename std::tuple_element<index, column_types>::type;
+
+    void parse_specs(const char *const *, std::integral_constant<size_t, num_columns>)
+    {
+    }
+
+    template <size_t index>
+    void parse_specs(const char *const *specs, std::integral_constant<size_t, index>)
+    {
+        std::get<index>(options) = format_options<column_type<index>>(specs[index]);
+        parse_specs(specs, std::integral_constant<size_t, index + 1>());
+    }
+
+    template <typename Tuple>
+    void write_fields(const Tuple &, std::integral_constant<size_t, num_columns>)
+    {
+    }
+
+    template <typename Tuple, size_t index>
+    void write_fields(const Tuple &fields, std::integral_constant<size_t, index>)
+    {
+        if (index > 0)
+            write(ctx.out(), &dialect.delimiter, 1);
+        csv_field_writer<column_type<index>>::write_field(
+            ctx, std::get<index>(fields), std::get<index>(options), dialect);
+        write_fields(fields, std::integral_constant<size_t, index + 1>());
+    }
+
+    output_context<Output &> ctx;
+    std::tuple<format_options<Columns>...> options;
+    csv_dialect dialect;
+};
+
+template <typename Output, typename... Columns>
+constexpr size_t csv_writer<Output, Columns...>::num_columns;
+
+} // formatpp
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef FORMATPP_ERROR_H_
+#define FORMATPP_ERROR_H_
+
+#include "constexpr.h"
+
+// Without exception support (e.g. -fno-exceptions), errors are reported with error codes
+#if !defined(FORMATPP_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(__EXCEPTIONS)
+#define FORMATPP_NO_EXCEPTIONS
+#endif
+
+namespace formatpp {
+
+/// @brief Errors returned by `vformat` / `format_to` when the library is built with `FORMATPP_NO_EXCEPTIONS`
+///
+/// With exceptions, the same errors are thrown as `std::runtime_error` (invalid specifiers and values),
+/// `std::logic_error` (invalid format strings and arguments), `std::out_of_range` (argument indices,
+/// `char_buf` overflow) and `std::bad_alloc`; the functions then always return `format_errc::ok`.
+enum class format_errc : int
+{
+    ok = 0,
+    /// An unmatched brace or an invalid argument index in the format string
+    invalid_format_string,
+    argument_index_out_of_range,
+    /// A format specifier that the argument's type doesn't accept
+    invalid_specifier,
+    /// A value that can't be formatted, e.g. a time point outside of the calendar
+    invalid_value,
+    /// Arguments that don't match what the function expects, e.g. the number of table columns
+    invalid_argument,
+    /// The output (a `char_buf`) is full; what fitted was written and null-terminated
+    buffer_overflow,
+    out_of_memory,
+    /// Malformed input data, e.g. a capture file
+    invalid_input
+};
+
+inline const char *message(format_errc e) noexcept
+{
+    switch (e)
+    {
+    case format_errc::ok:
+        return "Success";
+    case format_errc::invalid_format_string:
+        return "Invalid format string";
+    case format_errc::argument_index_out_of_range:
+        return "Argument index out of range";
+    case format_errc::invalid_specifier:
+        return "Invalid format specifier";
+    case format_errc::invalid_value:
+        return "Value cannot be formatted";
+    case format_errc::invalid_argument:
+        return "Invalid argument";
+    case format_errc::buffer_overflow:
+        return "Output buffer capacity exceeded";
+    case format_errc::out_of_memory:
+        return "Out of memory";
+    case format_errc::invalid_input:
+        return "Invalid input data";
+    }
+    return "Unknown error";
+}
+
+namespace detail {
+
+#ifdef FORMATPP_NO_EXCEPTIONS
+
+inline format_errc &error_state() noexcept
+{
+    static thread_local format_errc error = format_errc::ok;
+    return error;
+}
+
+/// The failing call stops at the next check of `failed`; not `constexpr`, so that errors in constant
+/// evaluation don't compile
+inline void report_error(format_errc e) noexcept
+{
+    error_state() = e;
+}
+
+FORMATPP_CONSTEXPR20 inline void clear_error() noexcept
+{
+    if (!is_constant_evaluated())
+        error_state() = format_errc::ok;
+}
+
+FORMATPP_CONSTEXPR20 inline bool failed() noexcept
+{
+    return !is_constant_evaluated() && error_state() != format_errc::ok;
+}
+
+#else
+
+FORMATPP_CONSTEXPR20 inline void clear_error() noexcept {}
+
+constexpr bool failed() noexcept
+{
+    return false;
+}
+
+#endif
+
+} // detail
+
+/// @brief The error of the last `vformat` / `format_to` call on this thread (e.g. to check `format_str`),
+/// or of a later failed call to another function, such as a table constructor; always `ok` when
+/// exceptions are used
+FORMATPP_CONSTEXPR20 inline format_errc last_error() noexcept
+{
+#ifdef FORMATPP_NO_EXCEPTIONS
+    return detail::is_constant_evaluated() ? format_errc::ok : detail::error_state();
+#else
+    return format_errc::ok;
+#endif
+}
+
+} // formatpp
+
+/// Throws `exception` or, with `FORMATPP_NO_EXCEPTIONS`, records `format_errc::code` and returns from
+/// the enclosing `void` function; the exception expression is not evaluated then
+#ifdef FORMATPP_NO_EXCEPTIONS
+#define FORMATPP_FAIL(code, exception) \
+    do \
+    { \
+        ::formatpp::detail::report_error(::formatpp::format_errc::code); \
+        return; \
+    } while (0)
+#define FORMATPP_FAIL_RETURN(code, exception, value) \
+    do \
+    { \
+        ::formatpp::detail::report_error(::formatpp::format_errc::code); \
+        return value; \
+    } while (0)
+#else
+#define FORMATPP_FAIL(code, exception) throw exception
+/// As `FORMATPP_FAIL`, returning `value` from a non-`void` function
+#define FORMATPP_FAIL_RETURN(code, exception, value) throw exception
+#endif
+
+#endif
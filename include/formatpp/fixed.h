@@ -0,0 +1,483 @@
+#ifndef FORMATPP_FIXED_H_
+#define FORMATPP_FIXED_H_
+
+#include "format.h"
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+
+namespace formatpp {
+
+/// @brief Output of `format_fixed`: an inline, null-terminated character array of capacity `N`
+///
+/// The capacity is the maximum formatted size, so appending needs no bounds checks (only asserts).
+/// Trivially copyable, e.g. into shared memory or a fixed-layout message. In C++20, `format_fixed` can
+/// initialize a `constexpr` one, baking the text into the binary.
+template <size_t N>
+class fixed_string
+{
+public:
+    FORMATPP_CONSTEXPR20 fixed_string() noexcept
+    {
+        // A constant must be fully initialized; at run time, the unused tail is left as it is
+        if (detail::is_constant_evaluated())
+            std::fill_n(buf, N + 1, '\0');
+        buf[0] = 0;
+    }
+
+    static constexpr size_t max_size() { return N; }
+
+    FORMATPP_CONSTEXPR20 void append(const char *str, size_t count) noexcept
+    {
+        assert(len + count <= N);
+        std::copy_n(str, count, buf + len);
+        len += count;
+        buf[len] = 0;
+    }
+
+    FORMATPP_CONSTEXPR20 void append(size_t count, char value) noexcept
+    {
+        assert(len + count <= N);
+        std::fill_n(buf + len, count, value);
+        len += count;
+        buf[len] = 0;
+    }
+
+    /// @brief Space for `count` characters at the end; null if they don't fit (some formatters reserve more than they write)
+    FORMATPP_CONSTEXPR20 char *reserve(size_t count) noexcept
+    {
+        return len + count <= N ? buf + len : nullptr;
+    }
+
+    FORMATPP_CONSTEXPR20 void commit(char *reserved, size_t count) noexcept
+    {
+        len = reserved - buf + count;
+        buf[len] = 0;
+    }
+
+    FORMATPP_CONSTEXPR20 char *data() noexcept { return buf; }
+    FORMATPP_CONSTEXPR20 const char *data() const noexcept { return buf; }
+    FORMATPP_CONSTEXPR20 const char *c_str() const noexcept { return buf; }
+    FORMATPP_CONSTEXPR20 size_t length() const noexcept { return len; }
+    FORMATPP_CONSTEXPR20 size_t size() const noexcept { return len; }
+    FORMATPP_CONSTEXPR20 const char *begin() const noexcept { return buf; }
+    FORMATPP_CONSTEXPR20 const char *end() const noexcept { return buf + len; }
+
+private:
+    size_t len = 0;
+    char buf[N + 1];
+};
+
+template <size_t N>
+StringType TypeCategory(const fixed_string<N> &);
+
+template <size_t N>
+FORMATPP_CONSTEXPR20 size_t string_length(const fixed_string<N> &s) { return s.length(); }
+
+template <size_t N, typename StringLike>
+FORMATPP_CONSTEXPR20 inline enable_if_t<is_string_type<StringLike>::value> put(fixed_string<N> &s, const StringLike &value)
+{
+    FORMATPP_SINK_WRITE(char_buf, string_length(value));
+    s.append(c_str(value), string_length(value));
+}
+
+template <size_t N, typename StringLike>
+FORMATPP_CONSTEXPR20 inline enable_if_t<is_string_type<StringLike>::value>
+put(fixed_string<N> &s, const StringLike &value, size_t max_len)
+{
+    FORMATPP_SINK_WRITE(char_buf, detail::min(max_len, string_length(value)));
+    s.append(c_str(value), detail::min(max_len, string_length(value)));
+}
+
+template <size_t N>
+FORMATPP_CONSTEXPR20 inline void put(fixed_string<N> &s, size_t n, char value)
+{
+    FORMATPP_SINK_WRITE(char_buf, n);
+    s.append(n, value);
+}
+
+template <size_t N>
+FORMATPP_CONSTEXPR20 inline void put(fixed_string<N> &s, char c)
+{
+    FORMATPP_SINK_WRITE(char_buf, 1);
+    s.append(&c, 1);
+}
+
+template <size_t N>
+FORMATPP_CONSTEXPR20 inline void write(fixed_string<N> &s, const char *str, size_t count)
+{
+    FORMATPP_SINK_WRITE(char_buf, count);
+    s.append(str, count);
+}
+
+template <size_t N>
+FORMATPP_CONSTEXPR20 inline char *reserve(fixed_string<N> &s, size_t count)
+{
+    return s.reserve(count);
+}
+
+template <size_t N>
+FORMATPP_CONSTEXPR20 inline void commit(fixed_string<N> &s, char *reserved, size_t count)
+{
+    FORMATPP_SINK_WRITE(char_buf, count);
+    s.commit(reserved, count);
+}
+
+namespace detail {
+
+// Not constexpr: reaching one of these while evaluating a bound makes it fail to compile
+inline size_t format_string_argument_index_out_of_range() { return 0; }
+inline const char *missing_closing_brace_in_format_string() { return nullptr; }
+inline size_t string_without_precision_has_no_size_bound() { return 0; }
+inline size_t binary_or_hex_float_has_no_size_bound() { return 0; }
+
+// Compile-time reading of format specifiers; `s` points past the colon, or at the closing brace
+// of a placeholder without a specifier. C++11 constexpr, hence the recursion.
+
+constexpr bool is_align_char(char c)
+{
+    return c == '<' || c == '^' || c == '>';
+}
+
+constexpr const char *skip_align(const char *s)
+{
+    return (*s && *s != '}' && is_align_char(s[1])) ? s + 2 : is_align_char(*s) ? s + 1 : s;
+}
+
+constexpr bool is_sign_char(char c)
+{
+    return c == '+' || c == ' ';
+}
+
+constexpr const char *skip_sign(const char *s)
+{
+    return is_sign_char(*s) ? s + 1 : s;
+}
+
+constexpr const char *skip_zero(const char *s)
+{
+    return *s == '0' ? s + 1 : s;
+}
+
+constexpr bool is_digit_char(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+constexpr size_t read_number(const char *s, size_t value = 0)
+{
+    return is_digit_char(*s) ? read_number(s + 1, value * 10 + (*s - '0')) : value;
+}
+
+constexpr const char *skip_number(const char *s)
+{
+    return is_digit_char(*s) ? skip_number(s + 1) : s;
+}
+
+/// -1 if there's no `.precision` at `s`
+constexpr long read_precision(const char *s)
+{
+    return *s == '.' ? static_cast<long>(read_number(s + 1)) : -1;
+}
+
+constexpr const char *skip_precision(const char *s)
+{
+    return *s == '.' ? skip_number(s + 1) : s;
+}
+
+/// Number of digits of `value` in `radix`
+constexpr size_t count_digits_in(unsigned long long value, unsigned radix)
+{
+    return value < radix ? 1 : 1 + count_digits_in(value / radix, radix);
+}
+
+constexpr size_t fixed_max(size_t a, size_t b)
+{
+    return a < b ? b : a;
+}
+
+constexpr size_t fixed_min(size_t a, size_t b)
+{
+    return a < b ? a : b;
+}
+
+/// Integers: `[[fill]align][sign][0][width][.precision][type]`
+template <typename T>
+constexpr size_t integer_size_bound(const char *type, bool sign, size_t width, long precision)
+{
+    return fixed_max(width,
+        (sign || std::is_signed<T>::value ? 1 : 0) + fixed_max(precision > 0 ? precision : 0,
+            count_digits_in(static_cast<unsigned long long>(std::numeric_limits<typename std::make_unsigned<T>::type>::max()),
+                            *type == 'b' || *type == 'B' ? 2
+                          : *type == 'o' || *type == 'O' ? 8
+                          : *type == 'x' || *type == 'X' ? 16
+                          : 10)));
+}
+
+constexpr bool fp_is_decimal(const char *type)
+{
+    return *type != 'b' && *type != 'B' && *type != 'a' && *type != 'A';
+}
+
+constexpr const char *fp_mode_char(const char *type)
+{
+    return (*type == 'd' || *type == 'b' || *type == 'B' || *type == 'a' || *type == 'A') ? type + 1 : type;
+}
+
+/// Integral digits of the largest value
+template <typename T>
+constexpr size_t fp_integral_digits()
+{
+    return std::numeric_limits<T>::max_exponent10 + 1;
+}
+
+/// Digits of the largest exponent, that of the smallest (subnormal) value
+template <typename T>
+constexpr size_t fp_exponent_digits()
+{
+    return count_digits_in(std::numeric_limits<T>::digits10 - std::numeric_limits<T>::min_exponent10 + 1, 10);
+}
+
+/// Sign, leading digit, point, `precision` digits, `e`, exponent sign and digits
+template <typename T>
+constexpr size_t fp_scientific_bound(size_t precision)
+{
+    return 3 + precision + 2 + fp_exponent_digits<T>();
+}
+
+/// Sign, integral digits, point and fraction digits
+constexpr size_t fp_positional_bound(size_t integral, size_t fraction)
+{
+    return 2 + integral + fraction;
+}
+
+/// Automatic mode is positional for exponents up to `limit` (the width, or else the precision) in magnitude:
+/// up to `limit + 1` integral digits, or `limit` leading zeros and `precision` digits after the point
+template <typename T>
+constexpr size_t fp_automatic_bound(size_t limit, size_t precision)
+{
+    return fixed_max(fp_scientific_bound<T>(precision), fp_positional_bound(limit + 1, limit + precision));
+}
+
+template <typename T>
+constexpr size_t fp_mode_bound(char mode, size_t width, long precision)
+{
+    return (mode == 'f' || mode == 'F') ? fp_positional_bound(fp_integral_digits<T>(), precision >= 0 ? precision : 6)
+         : (mode == 'e' || mode == 'E') ? fp_scientific_bound<T>(precision >= 0 ? precision : 6)
+         : (mode == 'x' || mode == 'X') ? 2 * sizeof(T)
+         : fp_automatic_bound<T>(width > 0 ? width : precision > 0 ? precision : 6, precision >= 0 ? precision : 6);
+}
+
+/// Floating point: `[[fill]align][sign][0][width][.precision][d][f|e|g|x]`; at least `-inf`.
+/// Binary and hex (`b`, `a`) floats aren't bounded.
+template <typename T>
+constexpr size_t fp_size_bound(const char *type, size_t width, long precision)
+{
+    return !fp_is_decimal(type) ? binary_or_hex_float_has_no_size_bound()
+         : fixed_max(width, fixed_max(4, fp_mode_bound<T>(*fp_mode_char(type), width, precision)));
+}
+
+/// Escaped strings take up to 6 characters per byte (`\u001f`) and 2 quotes
+constexpr size_t escaped_size(char type, size_t bytes)
+{
+    return (type == 'j' || type == 'q' || type == '?') ? 6 * bytes + 2 : bytes;
+}
+
+/// Padding in code points or columns adds up to `width` characters to the text
+constexpr size_t string_size_bound(char type, size_t width, size_t bytes)
+{
+    return (type == 'u' || type == 'w') ? width + bytes : fixed_max(width, escaped_size(type, bytes));
+}
+
+/// Strings of unknown length are bounded by their precision, which limits the bytes or code points read
+constexpr size_t precision_bytes(char type, long precision)
+{
+    return precision < 0 || type == 'w' ? string_without_precision_has_no_size_bound() : type == 'u' ? 4 * precision : precision;
+}
+
+/// Character arrays hold at most `array_size - 1` characters
+constexpr size_t string_bytes(char type, long precision, size_t array_size)
+{
+    return array_size == 0 ? precision_bytes(type, precision)
+         : precision < 0 || type == 'w' ? array_size - 1
+         : fixed_min(array_size - 1, precision_bytes(type, precision));
+}
+
+} // detail
+
+/// @brief Maximum number of characters that formatting a `T` with the specifier `spec` produces
+///
+/// `spec` points past the colon of the placeholder (or at the closing brace of `{}`).
+/// Specialize for other types to use them with `max_formatted_size` and `format_fixed`;
+/// `get` must be `constexpr`.
+template <typename T, typename Category = category<T>>
+struct size_bound
+{
+    static_assert(sizeof(T) == 0, "The formatted size of this type is not bounded; specialize formatpp::size_bound");
+    static constexpr size_t get(const char *) { return 0; }
+};
+
+template <typename T>
+struct size_bound<T, IntegralType>
+{
+    static constexpr size_t get(const char *spec)
+    {
+        return get(detail::skip_align(spec), detail::skip_zero(detail::skip_sign(detail::skip_align(spec))));
+    }
+
+private:
+    static constexpr size_t get(const char *after_align, const char *width)
+    {
+        return detail::integer_size_bound<T>(detail::skip_precision(detail::skip_number(width)),
+                                             detail::is_sign_char(*after_align),
+                                             detail::read_number(width),
+                                             detail::read_precision(detail::skip_number(width)));
+    }
+};
+
+template <typename T>
+struct size_bound<T, FloatingPointType>
+{
+    static constexpr size_t get(const char *spec)
+    {
+        return bound(detail::skip_zero(detail::skip_sign(detail::skip_align(spec))));
+    }
+
+private:
+    static constexpr size_t bound(const char *width)
+    {
+        return detail::fp_size_bound<T>(detail::skip_precision(detail::skip_number(width)),
+                                        detail::read_number(width),
+                                        detail::read_precision(detail::skip_number(width)));
+    }
+};
+
+template <typename T>
+struct size_bound<T, BooleanType>
+{
+    static constexpr size_t get(const char *spec)
+    {
+        return detail::fixed_max(detail::read_number(detail::skip_align(spec)), 5);
+    }
+};
+
+template <typename T>
+struct size_bound<T, CharType>
+{
+    static constexpr size_t get(const char *spec)
+    {
+        return detail::fixed_max(detail::read_number(detail::skip_align(spec)), 1);
+    }
+};
+
+/// Strings: character arrays by their size, other strings by their precision
+template <typename T>
+struct size_bound<T, StringType>
+{
+    static constexpr size_t get(const char *spec)
+    {
+        return get(detail::skip_align(spec), std::extent<T>::value);
+    }
+
+private:
+    static constexpr size_t get(const char *width, size_t array_size)
+    {
+        return get(width, detail::skip_precision(detail::skip_number(width)), array_size);
+    }
+
+    static constexpr size_t get(const char *width, const char *type, size_t array_size)
+    {
+        return detail::string_size_bound(*type, detail::read_number(width),
+            detail::string_bytes(*type, detail::read_precision(detail::skip_number(width)), array_size));
+    }
+};
+
+namespace detail {
+
+template <typename... Args>
+struct arg_size_bounds;
+
+template <>
+struct arg_size_bounds<>
+{
+    static constexpr size_t get(int index, const char *)
+    {
+        return index < 0 ? 0 : format_string_argument_index_out_of_range();
+    }
+};
+
+template <typename T, typename... Rest>
+struct arg_size_bounds<T, Rest...>
+{
+    static constexpr size_t get(int index, const char *spec)
+    {
+        return index == 0
+            ? size_bound<typename std::remove_cv<typename std::remove_reference<T>::type>::type>::get(spec)
+            : arg_size_bounds<Rest...>::get(index - 1, spec);
+    }
+};
+
+constexpr const char *skip_to_close(const char *s)
+{
+    return *s == '}' ? s + 1 : *s ? skip_to_close(s + 1) : missing_closing_brace_in_format_string();
+}
+
+template <typename... Args>
+constexpr size_t format_size_bound(const char *s, int last_index);
+
+/// `s` points past the opening brace; an explicit index also becomes the last one, as in `vformat`
+template <typename... Args>
+constexpr size_t placeholder_size_bound(const char *s, int index)
+{
+    return arg_size_bounds<Args...>::get(index, *s == ':' ? s + 1 : s)
+         + format_size_bound<Args...>(skip_to_close(s), index);
+}
+
+template <typename... Args>
+constexpr size_t format_size_bound(const char *s, int last_index)
+{
+    return *s == '\0' ? 0
+         : (*s == '{' && s[1] == '{') || (*s == '}' && s[1] == '}') ? 1 + format_size_bound<Args...>(s + 2, last_index)
+         : *s == '{' ? placeholder_size_bound<Args...>(
+               skip_number(s + 1), is_digit_char(s[1]) ? static_cast<int>(read_number(s + 1)) : last_index + 1)
+         : 1 + format_size_bound<Args...>(s + 1, last_index);
+}
+
+} // detail
+
+/// @brief Maximum length of the output of formatting `Args` with the format string `Format::get()`
+///
+/// Computed at compile time from the specifiers and argument types, for any values:
+/// `max_formatted_size<record_format, uint32_t, int16_t>()`. Fails to compile if a type has no
+/// `size_bound`, a float is formatted in binary or hex, or the format string is invalid.
+template <typename Format, typename... Args>
+constexpr size_t max_formatted_size()
+{
+    return detail::format_size_bound<Args...>(Format::get(), -1);
+}
+
+/// @brief Formats into an inline array of exactly `max_formatted_size` characters
+///
+/// ```
+/// FORMATPP_FORMAT_STRING(record_format, "{:08x} {}");
+/// auto record = format_fixed<record_format>(id, value);  // fixed_string<15> for uint32_t, int16_t
+/// ```
+template <typename Format, typename... Args>
+FORMATPP_CONSTEXPR20 fixed_string<max_formatted_size<Format, Args...>()> format_fixed(Args&&... args)
+{
+    fixed_string<max_formatted_size<Format, Args...>()> out;
+    format_to(out, Format::get(), std::forward<Args>(args)...);
+    return out;
+}
+
+} // formatpp
+
+/// Defines a type holding a format string literal, for `max_formatted_size` and `format_fixed`
+#define FORMATPP_FORMAT_STRING(name, literal) \
+    struct name \
+    { \
+        static constexpr const char *get() { return literal; } \
+    }
+
+#endif
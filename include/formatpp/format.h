@@ -2,26 +2,42 @@
 #define FORMATPP_CORE_H_
 
 #include <string>
+#include <algorithm>
 #include <cstring>
+#include <cstdlib>
 #include <sstream>
 #include <iostream>
 #include <cassert>
 #include <climits>
 #include <cmath>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
 #include <tuple>
 #include <type_traits>
+#include <vector>
+#include "capture.h"
+#include "constexpr.h"
+#include "error.h"
+#include "profile.h"
+#include "scratch.h"
+#include "simd.h"
+#include "size_hint.h"
+#include "stats.h"
+#include "unicode.h"
 
 namespace formatpp {
 namespace detail {
 
 template <typename T>
-T max(const T &a, const T &b)
+constexpr T max(const T &a, const T &b)
 {
     return a < b ? b : a;
 }
 
 template <typename T>
-T min(const T &a, const T &b)
+constexpr T min(const T &a, const T &b)
 {
     return b < a ? b : a;
 }
@@ -363,64 +379,202 @@ public:
     using char_t = Char;
 
     char_buf() = default;
-    char_buf(char_t *buffer, size_t capacity) : buf(buffer), cap(capacity)
+    FORMATPP_CONSTEXPR20 char_buf(char_t *buffer, size_t capacity) : buf(buffer), cap(capacity)
     {
     }
 
-    void append(const char_t *str, size_t count)
+    FORMATPP_CONSTEXPR20 void append(const char_t *str, size_t count)
     {
         if (len + count >= cap)
-            throw std::out_of_range("char_buf capacity exceeded");
+        {
+            count = overflow(count);
+            for (size_t i = 0; i < count; i++)
+                buf[len + i] = str[i];
+            return terminate(count);
+        }
         for (size_t i = 0; i < count; i++)
             buf[len + i] = str[i];
         len += count;
         buf[len] = 0; // null-terminate
     }
 
-    void append(const char_t *str)
+    FORMATPP_CONSTEXPR20 void append(const char_t *str)
     {
         while (char_t c = *str++)
         {
             if (len + 1 >= cap)
-                throw std::out_of_range("char_buf capacity exceeded");
+            {
+                overflow(1);
+                return terminate(0);
+            }
             buf[len++] = c;
         }
         buf[len] = 0;
     }
 
-    void append(size_t count, char_t value)
+    FORMATPP_CONSTEXPR20 void append(size_t count, char_t value)
     {
         if (len + count >= cap)
-            throw std::out_of_range("char_buf capacity exceeded");
-        for (size_t i = 0; i < count; i++)
-            buf[len + i] = value;
+        {
+            count = overflow(count);
+            std::fill_n(buf + len, count, value);
+            return terminate(count);
+        }
+        std::fill_n(buf + len, count, value);
         len += count;
 
         buf[len] = 0;
     }
 
+    /// @brief Space for `count` characters at the end, to be finished with `commit`; null if they don't fit
+    FORMATPP_CONSTEXPR20 char_t *reserve(size_t count) noexcept
+    {
+        return len + count < cap ? buf + len : nullptr;
+    }
+
+    /// @brief Appends `count` characters written at `reserved`, which was returned by `reserve`
+    FORMATPP_CONSTEXPR20 void commit(char_t *reserved, size_t count) noexcept
+    {
+        len = reserved - buf + count;
+        buf[len] = 0;
+    }
+
     using iterator = char_t*;
     using const_iterator = const char_t*;
-    iterator begin() { return data(); }
-    const_iterator cbegin() const { return data(); }
-    const_iterator begin() const { return data(); }
-    iterator end() { return data() + length(); }
-    const_iterator cend() const { return data() + length(); }
-    const_iterator end() const { return data() + length(); }
-
-    char_t *data() noexcept { return buf; }
-    const char_t *data() const noexcept { return buf; }
-    const char_t *c_str() const noexcept { return buf; }
-    size_t length() const noexcept { return len; }
-    size_t size() const noexcept { return len; }
-    size_t capacity() const noexcept { return cap; }
+    FORMATPP_CONSTEXPR20 iterator begin() { return data(); }
+    FORMATPP_CONSTEXPR20 const_iterator cbegin() const { return data(); }
+    FORMATPP_CONSTEXPR20 const_iterator begin() const { return data(); }
+    FORMATPP_CONSTEXPR20 iterator end() { return data() + length(); }
+    FORMATPP_CONSTEXPR20 const_iterator cend() const { return data() + length(); }
+    FORMATPP_CONSTEXPR20 const_iterator end() const { return data() + length(); }
+
+    FORMATPP_CONSTEXPR20 char_t *data() noexcept { return buf; }
+    FORMATPP_CONSTEXPR20 const char_t *data() const noexcept { return buf; }
+    FORMATPP_CONSTEXPR20 const char_t *c_str() const noexcept { return buf; }
+    FORMATPP_CONSTEXPR20 size_t length() const noexcept { return len; }
+    FORMATPP_CONSTEXPR20 size_t size() const noexcept { return len; }
+    FORMATPP_CONSTEXPR20 size_t capacity() const noexcept { return cap; }
 
 private:
+    /// Throws or, without exceptions, reports the overflow and returns how many of `count` characters fit
+    FORMATPP_CONSTEXPR20 size_t overflow(size_t count)
+    {
+        FORMATPP_FAIL_RETURN(buffer_overflow, std::out_of_range("char_buf capacity exceeded"),
+                             cap > len ? std::min(count, cap - len - 1) : 0);
+    }
+
+    FORMATPP_CONSTEXPR20 void terminate(size_t count) noexcept
+    {
+        len += count;
+        if (len < cap)
+            buf[len] = 0;
+    }
+
     char_t *buf = nullptr;
     size_t len = 0;
     size_t cap = 0;
 };
 
+/// @brief A large output buffer which is flushed to a stream only when full
+///
+/// Writes larger than the buffer bypass it and go directly to the stream.
+class buffered_sink
+{
+public:
+    static constexpr size_t default_capacity = 1 << 16;
+
+    explicit buffered_sink(std::ostream &stream, size_t capacity = default_capacity)
+    : stream(stream), buf(new char[capacity]), cap(capacity)
+    {
+    }
+
+    buffered_sink(const buffered_sink &) = delete;
+    buffered_sink &operator=(const buffered_sink &) = delete;
+
+    ~buffered_sink()
+    {
+        flush();
+    }
+
+    void append(const char *str, size_t count)
+    {
+        if (len + count > cap)
+        {
+            flush();
+            if (count >= cap)
+            {
+                stream.write(str, count);
+                return;
+            }
+        }
+        std::memcpy(buf.get() + len, str, count);
+        len += count;
+    }
+
+    void append(size_t count, char value)
+    {
+        while (count > 0)
+        {
+            if (len == cap)
+                flush();
+            size_t blk = count < cap - len ? count : cap - len;
+            std::memset(buf.get() + len, value, blk);
+            len += blk;
+            count -= blk;
+        }
+    }
+
+    /// @brief Space for `count` characters, to be finished with `commit`; null if more than the capacity
+    char *reserve(size_t count)
+    {
+        if (len + count > cap)
+        {
+            flush();
+            if (count > cap)
+                return nullptr;
+        }
+        return buf.get() + len;
+    }
+
+    /// @brief Appends `count` characters written at `reserved`, which was returned by `reserve`
+    void commit(char *reserved, size_t count) noexcept
+    {
+        len = reserved - buf.get() + count;
+    }
+
+    void flush()
+    {
+        if (len)
+        {
+            stream.write(buf.get(), len);
+            len = 0;
+        }
+    }
+
+    size_t buffered() const noexcept { return len; }
+    size_t capacity() const noexcept { return cap; }
+
+private:
+    std::ostream &stream;
+    std::unique_ptr<char[]> buf;
+    size_t len = 0;
+    size_t cap = 0;
+};
+
+/// @brief An output which only counts the characters written to it
+struct counting_sink
+{
+    size_t count = 0;
+};
+
+/// @brief Tells if the width and precision of strings written to `Output` are in code points by default
+///
+/// True for outputs which store text in another encoding than UTF-8, where a byte count would
+/// not match the number of characters, e.g. `wide_sink`.
+template <typename Output>
+struct measures_code_points : std::false_type
+{};
+
 using std::size_t;
 using std::ptrdiff_t;
 
@@ -439,7 +593,7 @@ enum class fp_format_mode
 /// @brief Tells if `c` is ASCII digit.
 /// @remarks `isdigit` can return true for digits in other encodings,
 ///           which we don't support in format strings
-inline bool is_ascii_digit(char c)
+constexpr bool is_ascii_digit(char c)
 {
     return c >= '0' && c <= '9';
 }
@@ -453,10 +607,40 @@ class PointerType;
 class StringType;
 class CharType;
 class BooleanType;
+class RangeType;
+class TupleType;
 
 template <typename T>
 class formatter;
 
+namespace detail {
+
+template <typename T>
+struct is_iterable
+{
+    template <typename U>
+    static auto test(int) -> decltype(std::begin(std::declval<const U &>()) != std::end(std::declval<const U &>()),
+                                      std::true_type());
+    template <typename U>
+    static std::false_type test(...);
+
+    static constexpr bool value = decltype(test<T>(0))::value &&
+                                  !std::is_convertible<const T &, const char *>::value;
+};
+
+template <typename T>
+struct is_map_like
+{
+    template <typename U>
+    static std::true_type test(typename U::mapped_type *);
+    template <typename U>
+    static std::false_type test(...);
+
+    static constexpr bool value = decltype(test<T>(nullptr))::value;
+};
+
+} // detail
+
 template <typename T>
 enable_if_t<std::is_integral<T>::value, IntegralType> TypeCategory(const T &);
 
@@ -475,12 +659,24 @@ template <typename T>
 PointerType TypeCategory(T *);
 
 template <typename Char>
-size_t string_length(const std::basic_string<Char> &s) { return s.length(); }
+StringType TypeCategory(const char_buf<Char> &);
+
+template <typename T>
+enable_if_t<detail::is_iterable<T>::value, RangeType> TypeCategory(const T &);
+
+template <typename First, typename Second>
+TupleType TypeCategory(const std::pair<First, Second> &);
 
-inline size_t string_length(const char *s) { return std::strlen(s); }
+template <typename... Elements>
+TupleType TypeCategory(const std::tuple<Elements...> &);
 
 template <typename Char>
-inline size_t string_length(const char_buf<Char> &s) { return s.length(); }
+FORMATPP_CONSTEXPR20 size_t string_length(const std::basic_string<Char> &s) { return s.length(); }
+
+FORMATPP_CONSTEXPR20 inline size_t string_length(const char *s) { return std::char_traits<char>::length(s); }
+
+template <typename Char>
+FORMATPP_CONSTEXPR20 inline size_t string_length(const char_buf<Char> &s) { return s.length(); }
 
 void TypeCategory(...);
 
@@ -490,16 +686,95 @@ struct type_category
     using type = decltype(TypeCategory(std::declval<T>()));
 };
 
+template <typename T, size_t N>
+struct type_category<T[N]>
+{
+    using type = typename std::conditional<std::is_convertible<T *, const char *>::value,
+                                           StringType, RangeType>::type;
+};
+
 template <typename T>
 using category = typename type_category<T>::type;
 
 template <typename T>
 using is_string_type = std::is_same<category<T>, StringType>;
 
-struct integer_format_options
+enum class alignment : char
 {
-    void parse(const char *options, size_t &i)
+    /// Formatter default - right
+    none,
+    left,
+    center,
+    right
+};
+
+/// @brief Fill character and alignment, `[[fill]<|^|>]`, common to all option structs
+struct align_options
+{
+    FORMATPP_CONSTEXPR20 void parse_align(const char *options, size_t &i)
+    {
+        if (options[i] && options[i] != '}' && to_alignment(options[i + 1]) != alignment::none)
+        {
+            fill = options[i];
+            align = to_alignment(options[i + 1]);
+            i += 2;
+        }
+        else if (to_alignment(options[i]) != alignment::none)
+        {
+            align = to_alignment(options[i]);
+            i++;
+        }
+    }
+
+    FORMATPP_CONSTEXPR20 static alignment to_alignment(char c)
+    {
+        switch (c)
+        {
+        case '<':
+            return alignment::left;
+        case '^':
+            return alignment::center;
+        case '>':
+            return alignment::right;
+        default:
+            return alignment::none;
+        }
+    }
+
+    char fill = ' ';
+    alignment align = alignment::none;
+};
+
+namespace detail {
+
+struct padding
+{
+    size_t before, after;
+};
+
+FORMATPP_CONSTEXPR20 inline padding compute_padding(const align_options &options, int width, size_t length)
+{
+    if (width <= 0 || length >= static_cast<size_t>(width))
+        return { 0, 0 };
+    size_t total = width - length;
+    switch (options.align)
+    {
+    case alignment::left:
+        return { 0, total };
+    case alignment::center:
+        return { total / 2, total - total / 2 };
+    default:
+        return { total, 0 };
+    }
+}
+
+} // detail
+
+struct integer_format_options : align_options
+{
+    FORMATPP_CONSTEXPR20 void parse(const char *options, size_t &i)
     {
+        parse_align(options, i);
         char c;
         switch (c = options[i])
         {
@@ -572,10 +847,11 @@ struct integer_format_options
             radix = 16;
             digits = uppercase_digits();
             break;
+        case '}':
         case '\0':
             break;
         default:
-            throw std::runtime_error(std::string("Invalid format specifier for an integer: ") + options);
+            FORMATPP_FAIL(invalid_specifier, std::runtime_error(std::string("Invalid format specifier for an integer: ") + options));
         }
     }
 
@@ -585,21 +861,22 @@ struct integer_format_options
     char leading_sign = 0;
     bool is_signed = true;
     char leading_char = ' ';
-    static const char *lowercase_digits()
+    static constexpr const char *lowercase_digits()
     {
         return "0123456789abcdefghijklmnopqrstuvwxyz";
     }
-    static const char *uppercase_digits()
+    static constexpr const char *uppercase_digits()
     {
         return "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
     }
     const char *digits = lowercase_digits();
 };
 
-struct fp_format_options
+struct fp_format_options : align_options
 {
     void parse(const char *options, size_t &i)
     {
+        parse_align(options, i);
         char c;
         switch (c = options[i])
         {
@@ -666,10 +943,11 @@ struct fp_format_options
         case 'x':
         case 'X':
             break;
+        case '}':
         case '\0':
             return;
         default:
-            throw std::runtime_error(std::string("Invalid format specifier for a floating point number: ") + options);
+            FORMATPP_FAIL(invalid_specifier, std::runtime_error(std::string("Invalid format specifier for a floating point number: ") + options));
         }
 
         switch (c = options[i])
@@ -717,11 +995,13 @@ struct fp_format_options
     const char *digits = lowercase_digits();
 };
 
-struct bool_format_options
+struct bool_format_options : align_options
 {
-    void parse(const char *options, size_t &i)
+    FORMATPP_CONSTEXPR20 void parse(const char *options, size_t &i)
     {
-        while (char c = is_ascii_digit(options[i]))
+        parse_align(options, i);
+        char c;
+        while (is_ascii_digit(c = options[i]))
         {
             if (width < 0)
                 width = c - '0';
@@ -733,39 +1013,31 @@ struct bool_format_options
         switch (options[i])
         {
         case 'b':
-            values = lowercase();
+            set_values("false", "true");
             break;
         case 'B':
-            values = uppercase();
+            set_values("False", "True");
             break;
         case 'i':
-            values = numeric();
+            set_values("0", "1");
             break;
         }
     }
-    static const char **lowercase()
+    FORMATPP_CONSTEXPR20 void set_values(const char *false_value, const char *true_value)
     {
-        static const char *values[] = { "false", "true" };
-        return values;
+        values[0] = false_value;
+        values[1] = true_value;
     }
-    static const char **uppercase()
-    {
-        static const char *values[] = { "False", "True" };
-        return values;
-    }
-    static const char **numeric()
-    {
-        static const char *values[] = { "0", "1" };
-        return values;
-    }
-    const char **values = lowercase();
+    /// Held by value rather than in static tables, which constant evaluation can't use before C++23
+    const char *values[2] = { "false", "true" };
     int width = -1;
 };
 
-struct default_options
+struct default_options : align_options
 {
-    void parse(const char *options, size_t &i)
+    FORMATPP_CONSTEXPR20 void parse(const char *options, size_t &i)
     {
+        parse_align(options, i);
         char c;
         while (is_ascii_digit(c = options[i]))
         {
@@ -789,10 +1061,198 @@ struct default_options
     int precision = -1;
 };
 
+template <typename T>
+struct format_options;
+
+template <typename Range>
+using range_element_t = typename std::decay<decltype(*std::begin(std::declval<const Range &>()))>::type;
+
+/// @brief Options for formatting ranges, parsed once for all elements
+///
+/// Syntax: `[n|[|(|<]['separator'][:element_options]`, e.g. `{:n' ':02x}` prints `01 0a ff`.
+/// Sequences are enclosed in square brackets, maps in curly braces.
+template <typename Range>
+struct range_format_options
+{
+    using element_type = range_element_t<Range>;
+    static constexpr bool is_map = detail::is_map_like<Range>::value;
+
+    range_format_options()
+    {
+        init(std::integral_constant<bool, is_map>());
+    }
+
+    void parse(const char *options, size_t &i)
+    {
+        switch (options[i])
+        {
+        case 'n':
+            open = close = 0;
+            i++;
+            break;
+        case '[':
+            open = '[';
+            close = ']';
+            i++;
+            break;
+        case '(':
+            open = '(';
+            close = ')';
+            i++;
+            break;
+        case '<':
+            open = '<';
+            close = '>';
+            i++;
+            break;
+        }
+
+        if (options[i] == '\'')
+        {
+            size_t start = ++i;
+            while (options[i] != '\'')
+            {
+                if (!options[i])
+                    FORMATPP_FAIL(invalid_specifier, std::runtime_error(std::string("Unterminated separator in range format specifier: ") + options));
+                i++;
+            }
+            set_separator(options + start, i - start);
+            i++;
+        }
+
+        if (options[i] == ':')
+        {
+            i++;
+            element.parse(options, i);
+        }
+        else if (options[i] != '}' && options[i] != '\0')
+            FORMATPP_FAIL(invalid_specifier, std::runtime_error(std::string("Invalid format specifier for a range: ") + options));
+    }
+
+    void set_separator(const char *str, size_t length)
+    {
+        if (length >= sizeof(separator))
+            FORMATPP_FAIL(invalid_specifier, std::runtime_error("Range separator too long"));
+        std::memcpy(separator, str, length);
+        separator[length] = 0;
+        separator_length = length;
+    }
+
+private:
+    void init(std::false_type)
+    {
+    }
+
+    void init(std::true_type)
+    {
+        open = '{';
+        close = '}';
+        element.brackets = false;
+        element.set_separator(": ", 2);
+    }
+
+public:
+    char open = '[';
+    char close = ']';
+    char separator[16] = ", ";
+    size_t separator_length = 2;
+    format_options<element_type> element;
+};
+
+template <typename Range>
+constexpr bool range_format_options<Range>::is_map;
+
+/// @brief Options for formatting pairs and tuples; `n` omits the parentheses
+struct tuple_format_options
+{
+    void parse(const char *options, size_t &i)
+    {
+        if (options[i] == 'n')
+        {
+            brackets = false;
+            i++;
+        }
+    }
+
+    void set_separator(const char *str, size_t length)
+    {
+        separator = str;
+        separator_length = length;
+    }
+
+    bool brackets = true;
+    const char *separator = ", ";
+    size_t separator_length = 2;
+};
+
+enum class string_escape
+{
+    none,
+    /// JSON string escaping (`\"`, `\\`, `\n`, `\u001f`), without the enclosing quotes
+    json,
+    /// A quoted C string literal, control characters and DEL as octal escapes; other bytes (UTF-8) are kept
+    c,
+    /// Control characters and backslashes escaped, for debug output
+    debug
+};
+
+/// @brief Options for strings: `[[fill]align][width][.precision][j|q|?|u|w]`
+///
+/// `j` escapes the string for JSON, `q` prints it as a quoted C string literal and `?`
+/// escapes control characters. Precision limits the input length, width applies to the output.
+/// `u` and `w` measure width and precision of UTF-8 text in code points and display columns,
+/// respectively, instead of bytes; truncation never splits a character.
+struct string_format_options : default_options
+{
+    FORMATPP_CONSTEXPR20 void parse(const char *options, size_t &i)
+    {
+        default_options::parse(options, i);
+        switch (options[i])
+        {
+        case 'j':
+            escape = string_escape::json;
+            i++;
+            break;
+        case 'q':
+            escape = string_escape::c;
+            i++;
+            break;
+        case '?':
+            escape = string_escape::debug;
+            i++;
+            break;
+        case 'u':
+            unit = string_width::code_points;
+            i++;
+            break;
+        case 'w':
+            unit = string_width::columns;
+            i++;
+            break;
+        }
+    }
+
+    string_escape escape = string_escape::none;
+    /// Unit of width and precision for unescaped strings, which are assumed to be UTF-8
+    string_width unit = string_width::bytes;
+};
+
 template <typename T, typename Category = category<T>>
 struct default_format_options : default_options
 {};
 
+template <typename T>
+struct default_format_options<T, StringType> : string_format_options
+{};
+
+template <typename T>
+struct default_format_options<T, RangeType> : range_format_options<T>
+{};
+
+template <typename T>
+struct default_format_options<T, TupleType> : tuple_format_options
+{};
+
 template <typename T>
 struct default_format_options<T, IntegralType> : integer_format_options
 {};
@@ -809,17 +1269,17 @@ template <typename T>
 struct format_options : default_format_options<T>
 {
     format_options() = default;
-    format_options(const char *options, size_t &i) { this->parse(options, i); }
-    format_options(const char *options) { size_t i = 0; this->parse(options, i); }
+    FORMATPP_CONSTEXPR20 format_options(const char *options, size_t &i) { this->parse(options, i); }
+    FORMATPP_CONSTEXPR20 format_options(const char *options) { size_t i = 0; this->parse(options, i); }
 };
 
 
 template <typename char_t>
-inline const char_t *c_str(const std::basic_string<char_t> &s) { return s.c_str(); }
-inline const char *c_str(const char *s) { return s; }
+FORMATPP_CONSTEXPR20 inline const char_t *c_str(const std::basic_string<char_t> &s) { return s.c_str(); }
+FORMATPP_CONSTEXPR20 inline const char *c_str(const char *s) { return s; }
 
 template <typename char_t>
-inline const char_t *c_str(const char_buf<char_t> &buf)
+FORMATPP_CONSTEXPR20 inline const char_t *c_str(const char_buf<char_t> &buf)
 {
     return buf.c_str();
 }
@@ -828,53 +1288,73 @@ inline const char_t *c_str(const char_buf<char_t> &buf)
 template <typename StringLike>
 inline enable_if_t<is_string_type<StringLike>::value> put(std::ostream &s, const StringLike &value)
 {
-    s << value;
+    FORMATPP_SINK_WRITE(ostream, string_length(value));
+    s.write(c_str(value), string_length(value));
 }
 
 template <typename StringLike>
-inline enable_if_t<is_string_type<StringLike>::value> put(std::string &s, const StringLike &value)
+FORMATPP_CONSTEXPR20 inline enable_if_t<is_string_type<StringLike>::value> put(std::string &s, const StringLike &value)
 {
-    s.append(value);
+    FORMATPP_SINK_WRITE(string, string_length(value));
+    s.append(c_str(value), string_length(value));
 }
 
 template <typename char_t, typename StringLike>
-inline enable_if_t<is_string_type<StringLike>::value> put(char_buf<char_t> &s, const StringLike &value)
+FORMATPP_CONSTEXPR20 inline enable_if_t<is_string_type<StringLike>::value> put(char_buf<char_t> &s, const StringLike &value)
 {
+    FORMATPP_SINK_WRITE(char_buf, string_length(value));
     s.append(c_str(value), string_length(value));
 }
 
 inline void put(std::ostream &s, char c)
 {
+    FORMATPP_SINK_WRITE(ostream, 1);
     s.put(c);
 }
 
+FORMATPP_CONSTEXPR20 inline void put(std::string &s, char c)
+{
+    FORMATPP_SINK_WRITE(string, 1);
+    s.push_back(c);
+}
+
+template <typename char_t>
+FORMATPP_CONSTEXPR20 inline void put(char_buf<char_t> &s, char c)
+{
+    FORMATPP_SINK_WRITE(char_buf, 1);
+    s.append(1, c);
+}
+
 template <typename StringLike>
 inline enable_if_t<is_string_type<StringLike>::value>
 put(std::ostream &s, const StringLike &value, size_t max_len)
 {
+    FORMATPP_SINK_WRITE(ostream, detail::min(max_len, string_length(value)));
     s.write(c_str(value), detail::min(max_len, string_length(value)));
 }
 
 template <typename StringLike>
-inline enable_if_t<is_string_type<StringLike>::value>
+FORMATPP_CONSTEXPR20 inline enable_if_t<is_string_type<StringLike>::value>
 put(std::string &s, const StringLike &value, size_t max_len)
 {
+    FORMATPP_SINK_WRITE(string, detail::min(max_len, string_length(value)));
     s.append(c_str(value), detail::min(max_len, string_length(value)));
 }
 
 template <typename char_t, typename StringLike>
-inline enable_if_t<is_string_type<StringLike>::value>
+FORMATPP_CONSTEXPR20 inline enable_if_t<is_string_type<StringLike>::value>
 put(char_buf<char_t> &s, const StringLike &value, size_t max_len)
 {
+    FORMATPP_SINK_WRITE(char_buf, detail::min(max_len, string_length(value)));
     s.append(c_str(value), detail::min(max_len, string_length(value)));
 }
 
 inline void put(std::ostream &s, size_t n, char value)
 {
+    FORMATPP_SINK_WRITE(ostream, n);
     const size_t max_blk = 256;
     char tmp[max_blk];
-    for (size_t i = 0; i < n && i < 64; i++)
-        tmp[i] = value;
+    std::memset(tmp, value, detail::min(n, max_blk));
     while (n > 0)
     {
         size_t blk = detail::min(n, max_blk);
@@ -885,28 +1365,214 @@ inline void put(std::ostream &s, size_t n, char value)
 
 
 
-inline void put(std::string &s, size_t n, char value)
+FORMATPP_CONSTEXPR20 inline void put(std::string &s, size_t n, char value)
 {
+    FORMATPP_SINK_WRITE(string, n);
     s.append(n, value);
 }
 
 template <typename char_t>
-inline void put(char_buf<char_t> &buf, size_t n, char value)
+FORMATPP_CONSTEXPR20 inline void put(char_buf<char_t> &buf, size_t n, char value)
 {
+    FORMATPP_SINK_WRITE(char_buf, n);
     buf.append(n, value);
 }
 
+template <typename StringLike>
+inline enable_if_t<is_string_type<StringLike>::value> put(buffered_sink &s, const StringLike &value)
+{
+    FORMATPP_SINK_WRITE(buffered_sink, string_length(value));
+    s.append(c_str(value), string_length(value));
+}
+
+template <typename StringLike>
+inline enable_if_t<is_string_type<StringLike>::value>
+put(buffered_sink &s, const StringLike &value, size_t max_len)
+{
+    FORMATPP_SINK_WRITE(buffered_sink, detail::min(max_len, string_length(value)));
+    s.append(c_str(value), detail::min(max_len, string_length(value)));
+}
+
+inline void put(buffered_sink &s, size_t n, char value)
+{
+    FORMATPP_SINK_WRITE(buffered_sink, n);
+    s.append(n, value);
+}
+
+inline void put(buffered_sink &s, char c)
+{
+    FORMATPP_SINK_WRITE(buffered_sink, 1);
+    s.append(&c, 1);
+}
+
+template <typename StringLike>
+FORMATPP_CONSTEXPR20 inline enable_if_t<is_string_type<StringLike>::value> put(counting_sink &s, const StringLike &value)
+{
+    FORMATPP_SINK_WRITE(counting_sink, string_length(value));
+    s.count += string_length(value);
+}
+
+template <typename StringLike>
+FORMATPP_CONSTEXPR20 inline enable_if_t<is_string_type<StringLike>::value>
+put(counting_sink &s, const StringLike &value, size_t max_len)
+{
+    FORMATPP_SINK_WRITE(counting_sink, detail::min(max_len, string_length(value)));
+    s.count += detail::min(max_len, string_length(value));
+}
+
+FORMATPP_CONSTEXPR20 inline void put(counting_sink &s, size_t n, char)
+{
+    FORMATPP_SINK_WRITE(counting_sink, n);
+    s.count += n;
+}
+
+FORMATPP_CONSTEXPR20 inline void put(counting_sink &s, char)
+{
+    FORMATPP_SINK_WRITE(counting_sink, 1);
+    s.count++;
+}
+
+/// @brief Writes exactly `count` characters, without looking for a null terminator
+inline void write(std::ostream &s, const char *str, size_t count)
+{
+    FORMATPP_SINK_WRITE(ostream, count);
+    s.write(str, count);
+}
+
+FORMATPP_CONSTEXPR20 inline void write(std::string &s, const char *str, size_t count)
+{
+    FORMATPP_SINK_WRITE(string, count);
+    s.append(str, count);
+}
+
+template <typename char_t>
+FORMATPP_CONSTEXPR20 inline void write(char_buf<char_t> &s, const char *str, size_t count)
+{
+    FORMATPP_SINK_WRITE(char_buf, count);
+    s.append(str, count);
+}
+
+inline void write(buffered_sink &s, const char *str, size_t count)
+{
+    FORMATPP_SINK_WRITE(buffered_sink, count);
+    s.append(str, count);
+}
+
+FORMATPP_CONSTEXPR20 inline void write(counting_sink &s, const char *, size_t count)
+{
+    FORMATPP_SINK_WRITE(counting_sink, count);
+    s.count += count;
+}
+
+/// @brief Direct output: `reserve` returns space for `count` characters at the end of a contiguous output;
+/// the caller writes up to `count` characters there and appends them with `commit(out, reserved, written)`
+///
+/// Outputs without these overloads, and reservations returning null, use `put`/`write`.
+FORMATPP_CONSTEXPR20 inline char *reserve(std::string &s, size_t count)
+{
+    size_t size = s.size();
+    s.resize(size + count);
+    return &s[size];
+}
+
+FORMATPP_CONSTEXPR20 inline void commit(std::string &s, char *reserved, size_t count)
+{
+    FORMATPP_SINK_WRITE(string, count);
+    s.resize(reserved - &s[0] + count);
+}
+
+FORMATPP_CONSTEXPR20 inline char *reserve(char_buf<char> &s, size_t count)
+{
+    return s.reserve(count);
+}
+
+FORMATPP_CONSTEXPR20 inline void commit(char_buf<char> &s, char *reserved, size_t count)
+{
+    FORMATPP_SINK_WRITE(char_buf, count);
+    s.commit(reserved, count);
+}
+
+inline char *reserve(buffered_sink &s, size_t count)
+{
+    return s.reserve(count);
+}
+
+inline void commit(buffered_sink &s, char *reserved, size_t count)
+{
+    FORMATPP_SINK_WRITE(buffered_sink, count);
+    s.commit(reserved, count);
+}
+
+namespace detail {
+
+template <typename Output>
+FORMATPP_CONSTEXPR20 auto reserve_direct(Output &out, size_t count, int) -> decltype(reserve(out, count))
+{
+    return reserve(out, count);
+}
+
+template <typename Output>
+FORMATPP_CONSTEXPR20 char *reserve_direct(Output &, size_t, long)
+{
+    return nullptr;
+}
+
+/// @brief Reserves space in `out` if it supports direct output; null otherwise
+template <typename Output>
+FORMATPP_CONSTEXPR20 char *reserve_direct(Output &out, size_t count)
+{
+    return reserve_direct(out, count, 0);
+}
+
+template <typename Output>
+FORMATPP_CONSTEXPR20 auto commit_direct(Output &out, char *reserved, size_t count, int) -> decltype(commit(out, reserved, count))
+{
+    commit(out, reserved, count);
+}
+
+template <typename Output>
+FORMATPP_CONSTEXPR20 void commit_direct(Output &, char *, size_t, long)
+{
+}
+
+/// @brief Commits a reservation made with `reserve_direct`
+template <typename Output>
+FORMATPP_CONSTEXPR20 void commit_direct(Output &out, char *reserved, size_t count)
+{
+    commit_direct(out, reserved, count, 0);
+}
+
+template <typename Output>
+struct has_direct_output
+{
+    template <typename O>
+    static auto test(int) -> decltype(reserve(std::declval<O &>(), size_t()), std::true_type());
+    template <typename O>
+    static std::false_type test(...);
+
+    static constexpr bool value = decltype(test<Output>(0))::value;
+};
+
+} // detail
+
+template <typename Output>
+FORMATPP_CONSTEXPR20 inline void put_fill(Output &out, size_t n, char fill)
+{
+    if (n)
+        put(out, n, fill);
+}
+
 template <typename T>
 struct bump_allocator
 {
     bump_allocator() = default;
-    bump_allocator(T *ptr, size_t count) : data(ptr), total(count) {}
+    FORMATPP_CONSTEXPR20 bump_allocator(T *ptr, size_t count) : data(ptr), total(count) {}
 
     T *data = nullptr;
     size_t total = 0;
     size_t used = 0;
 
-    T *allocate(size_t count)
+    FORMATPP_CONSTEXPR20 T *allocate(size_t count)
     {
         if (used + count > total)
             return nullptr;
@@ -915,7 +1581,7 @@ struct bump_allocator
         return ret;
     }
 
-    bool free(T *ptr, size_t count)
+    FORMATPP_CONSTEXPR20 bool free(T *ptr, size_t count)
     {
         if (ptr + count == data + used)
         {
@@ -927,17 +1593,69 @@ struct bump_allocator
     }
 };
 
+#ifdef FORMATPP_NO_HEAP
+
+#ifndef FORMATPP_SCRATCH_SIZE
+#define FORMATPP_SCRATCH_SIZE 8192
+#endif
+
+namespace detail {
+
+inline bump_allocator<char> *&scratch_override() noexcept
+{
+    static thread_local bump_allocator<char> *arena = nullptr;
+    return arena;
+}
+
+/// The arena that temporary buffers spill to: the calling thread's own, or one set with `scratch_scope`
+inline bump_allocator<char> &scratch_arena() noexcept
+{
+    static thread_local char storage[FORMATPP_SCRATCH_SIZE];
+    static thread_local bump_allocator<char> own(storage, sizeof(storage));
+    bump_allocator<char> *arena = scratch_override();
+    return arena ? *arena : own;
+}
+
+} // detail
+
+/// @brief Makes the calling thread's formatters spill temporary buffers to `buffer` until destroyed
+///
+/// Scopes nest; `buffer` should be at least `FORMATPP_SCRATCH_SIZE` bytes for `FORMATPP_BOUNDED`
+/// format strings to be guaranteed to fit.
+class scratch_scope
+{
+public:
+    scratch_scope(char *buffer, size_t size) noexcept : arena(buffer, size), prev(detail::scratch_override())
+    {
+        detail::scratch_override() = &arena;
+    }
+
+    ~scratch_scope()
+    {
+        detail::scratch_override() = prev;
+    }
+
+    scratch_scope(const scratch_scope &) = delete;
+    scratch_scope &operator=(const scratch_scope &) = delete;
+
+private:
+    bump_allocator<char> arena;
+    bump_allocator<char> *prev;
+};
+
+#endif
+
 struct tmp_buf_allocator
 {
     static constexpr size_t static_buffer_size = 256;
     char static_buf[static_buffer_size];
     static constexpr size_t num_allocs = 24;
     bump_allocator<char> allocs[num_allocs];
-    tmp_buf_allocator()
+    FORMATPP_CONSTEXPR20 tmp_buf_allocator()
     {
         allocs[0] = { static_buf, sizeof(static_buf) };
     }
-    ~tmp_buf_allocator()
+    FORMATPP_CONSTEXPR20 ~tmp_buf_allocator()
     {
         for (size_t i = 1; i < num_allocs; i++)
             delete[] allocs[i].data;
@@ -945,10 +1663,10 @@ struct tmp_buf_allocator
 
     struct buffer_lease
     {
-        buffer_lease(tmp_buf_allocator *owner, char *data, size_t count)
+        FORMATPP_CONSTEXPR20 buffer_lease(tmp_buf_allocator *owner, char *data, size_t count)
         : owner(owner), data(data), count(count) {}
         buffer_lease(const buffer_lease &) = delete;
-        buffer_lease(buffer_lease &&b)
+        FORMATPP_CONSTEXPR20 buffer_lease(buffer_lease &&b)
         {
             owner = b.owner;
             data = b.data;
@@ -957,12 +1675,12 @@ struct tmp_buf_allocator
             b.data = nullptr;
             b.count = 0;
         }
-        ~buffer_lease()
+        FORMATPP_CONSTEXPR20 ~buffer_lease()
         {
             release();
         }
 
-        void release()
+        FORMATPP_CONSTEXPR20 void release()
         {
             if (data)
             {
@@ -973,7 +1691,7 @@ struct tmp_buf_allocator
         }
 
         buffer_lease &operator=(const buffer_lease &b) = delete;
-        buffer_lease &operator=(buffer_lease &&b)
+        FORMATPP_CONSTEXPR20 buffer_lease &operator=(buffer_lease &&b)
         {
             release();
             owner = b.owner;
@@ -989,17 +1707,35 @@ struct tmp_buf_allocator
         char *data;
         size_t count;
 
-        char *get() const noexcept { return data; }
-        size_t size() const noexcept { return count; }
+        FORMATPP_CONSTEXPR20 char *get() const noexcept { return data; }
+        FORMATPP_CONSTEXPR20 size_t size() const noexcept { return count; }
     };
     char *tail = static_buf;
 
-    buffer_lease allocate(size_t count)
+    FORMATPP_CONSTEXPR20 buffer_lease allocate(size_t count)
     {
         return { this, allocate_raw(count), count };
     }
 
-    char *allocate_raw(size_t count)
+#ifdef FORMATPP_NO_HEAP
+    /// Without the heap, spills go to the thread's scratch arena; leases are released in reverse order
+    FORMATPP_CONSTEXPR20 char *allocate_raw(size_t count)
+    {
+        if (char *mem = allocs[0].allocate(count))
+            return mem;
+        FORMATPP_STAT_INC(tmp_buffer_spills);
+        if (char *mem = detail::scratch_arena().allocate(count))
+            return mem;
+        FORMATPP_FAIL_RETURN(out_of_memory, std::bad_alloc(), nullptr);
+    }
+
+    FORMATPP_CONSTEXPR20 void free(char *mem, size_t count)
+    {
+        if (!allocs[0].free(mem, count))
+            detail::scratch_arena().free(mem, count);
+    }
+#else
+    FORMATPP_CONSTEXPR20 char *allocate_raw(size_t count)
     {
         size_t prev_size = 0;
         for (size_t i = 0; i < num_allocs; i++)
@@ -1007,43 +1743,84 @@ struct tmp_buf_allocator
             if (allocs[i].data)
             {
                 if (char *mem = allocs[i].allocate(count))
+                {
+                    if (i > 0)
+                        FORMATPP_STAT_INC(tmp_buffer_spills);
                     return mem;
+                }
             }
             else
             {
+                FORMATPP_STAT_INC(tmp_buffer_spills);
                 size_t capacity = prev_size << 1;
                 while (count > capacity)
                     capacity <<= 1;
+#ifdef FORMATPP_NO_EXCEPTIONS
+                char *data = new (std::nothrow) char[capacity];
+                if (!data)
+                    FORMATPP_FAIL_RETURN(out_of_memory, std::bad_alloc(), nullptr);
+                allocs[i] = { data, capacity };
+#else
                 allocs[i] = { new char[capacity], capacity };
+#endif
                 return allocs[i].allocate(count);
             }
             prev_size = allocs[i].total;
         }
-        throw std::bad_alloc();
+        FORMATPP_FAIL_RETURN(out_of_memory, std::bad_alloc(), nullptr);
     }
 
-    void free(char *mem, size_t count)
+    FORMATPP_CONSTEXPR20 void free(char *mem, size_t count)
     {
         for (int i = num_allocs - 1; i >= 0; i--)
             if (allocs[i].free(mem, count))
                 break;
     }
+#endif
 };
 
+#ifdef FORMATPP_NO_HEAP
+
+/// @brief Scratch space guaranteed to a format call: a context's static buffer and the arena
+constexpr size_t scratch_capacity = tmp_buf_allocator::static_buffer_size + FORMATPP_SCRATCH_SIZE;
+
+namespace detail {
+
+template <bool fits>
+constexpr const char *bounded_format(const char *format_string)
+{
+    static_assert(fits, "The format string may need more scratch space than FORMATPP_SCRATCH_SIZE provides");
+    return format_string;
+}
+
+} // detail
+
+/// @brief A format string literal checked at compile time to fit the scratch capacity with the built-in
+/// formatters, whatever the values: `format_to(buf, FORMATPP_BOUNDED("{:>12.3f}"), x)`
+#define FORMATPP_BOUNDED(format_string) \
+    ::formatpp::detail::bounded_format<(::formatpp::scratch_bound(format_string) <= ::formatpp::scratch_capacity)>(format_string)
+
+#else
+
+#define FORMATPP_BOUNDED(format_string) (format_string)
+
+#endif
+
 template <typename Output>
 struct output_context
 {
-    output_context(Output output) : output(output) {}
+    FORMATPP_CONSTEXPR20 output_context(Output output) : output(output) {}
 
     using buf_lease = tmp_buf_allocator::buffer_lease;
     tmp_buf_allocator alloc;
 
-    buf_lease get_tmp_buffer(size_t count)
+    /// @brief Null only without exceptions, after reporting `format_errc::out_of_memory`
+    FORMATPP_CONSTEXPR20 buf_lease get_tmp_buffer(size_t count)
     {
         return alloc.allocate(count);
     }
 
-    typename std::add_lvalue_reference<Output>::type out()
+    FORMATPP_CONSTEXPR20 typename std::add_lvalue_reference<Output>::type out()
     {
         return output;
     }
@@ -1058,13 +1835,19 @@ template <typename T>
 struct ios_formatter
 {
     template <typename Context>
-    void format(Context &ctx, const T &value, const format_options<T> &options)
+    static void format(Context &ctx, const T &value, const format_options<T> &options)
     {
+#ifdef FORMATPP_NO_HEAP
+        static_assert(sizeof(T) == 0, "FORMATPP_NO_HEAP: the type has no formatter; operator<< would allocate");
+#endif
+        FORMATPP_STAT_INC(ios_fallback);
         std::ostringstream ss;
-        if (options.width > 0)
-            ss.width(options.width);
         ss << value;
-        put(ctx.out(), ss.str());
+        std::string str = ss.str();
+        auto pad = detail::compute_padding(options, options.width, str.length());
+        put_fill(ctx.out(), pad.before, options.fill);
+        put(ctx.out(), str);
+        put_fill(ctx.out(), pad.after, options.fill);
     }
 };
 
@@ -1075,13 +1858,14 @@ template <typename T>
 struct default_formatter<T, BooleanType>
 {
     template <typename Context>
-    static void format(Context &ctx, const T &value, const format_options<T> &options)
+    FORMATPP_CONSTEXPR20 static void format(Context &ctx, const T &value, const format_options<T> &options)
     {
         auto v = options.values[static_cast<bool>(value)];
-        int l = strlen(v);
-        if (options.width > l)
-            put(ctx.out(), options.width - l, ' ');
-        put(ctx.out(), v);
+        size_t l = string_length(v);
+        auto pad = detail::compute_padding(options, options.width, l);
+        put_fill(ctx.out(), pad.before, options.fill);
+        write(ctx.out(), v, l);
+        put_fill(ctx.out(), pad.after, options.fill);
     }
 };
 
@@ -1089,23 +1873,24 @@ template <typename T>
 struct default_formatter<T, CharType>
 {
     template <typename Context>
-    static void format(Context &ctx, const T &value, const format_options<T> &options)
+    FORMATPP_CONSTEXPR20 static void format(Context &ctx, const T &value, const format_options<T> &options)
     {
-        if (options.width > 1)
-            put(ctx.out(), options.width - 1, ' ');
+        auto pad = detail::compute_padding(options, options.width, 1);
+        put_fill(ctx.out(), pad.before, options.fill);
         put(ctx.out(), value);
+        put_fill(ctx.out(), pad.after, options.fill);
     }
 };
 
 template <typename T>
-inline T divmod(uint8_t &mod, T x, uint8_t radix)
+FORMATPP_CONSTEXPR20 inline T divmod(uint8_t &mod, T x, uint8_t radix)
 {
     mod = x % radix;
     return x / radix;
 }
 
 template <typename T, uint8_t radix>
-T divmod(uint8_t &mod, T x, std::integral_constant<uint8_t, radix>)
+FORMATPP_CONSTEXPR20 T divmod(uint8_t &mod, T x, std::integral_constant<uint8_t, radix>)
 {
     mod = x % radix;
     return x / radix;
@@ -1118,36 +1903,70 @@ struct default_formatter<T, IntegralType>
     using static_radix = std::integral_constant<uint8_t, r>;
 
     template <typename Context>
-    static void format(Context &ctx, const T &value, const format_options<T> &options)
+    FORMATPP_CONSTEXPR20 static void format(Context &ctx, const T &value, const format_options<T> &options)
     {
         format_fixed(ctx, value, options);
     }
 
     template <typename Context>
-    static void format_fixed(Context &ctx, const T &value, const format_options<T> &options, int fixed_point = 0, bool trim_trailing_zeros = false)
+    FORMATPP_CONSTEXPR20 static void format_fixed(Context &ctx, const T &value, const format_options<T> &options, int fixed_point = 0, bool trim_trailing_zeros = false)
     {
-        int buf_size = sizeof(T)*8 + 3;
-        if (options.width + 2 > buf_size)
-            buf_size = options.width + 2;
-        if (options.precision + 2 > buf_size)
-            buf_size = options.precision + 2;
-        auto buf_lease = ctx.get_tmp_buffer(buf_size);
-        char *buf = buf_lease.get();
-        char *rbuf = buf + buf_size - 1;
-        *rbuf = 0;
-        int n = 0;
         bool is_negative = false;
-        typename std::make_unsigned<T>::type x;
+        unsigned_t x;
         if (std::is_signed<T>::value && options.is_signed && value < 0)
         {
             is_negative = true;
-            x = -value;
+            x = unsigned_t(0) - static_cast<unsigned_t>(value);  // no overflow for the minimum
         }
         else
         {
             x = value;
         }
 
+        // Contiguous outputs get the digits directly, at an offset computed up front
+        using output_t = typename std::remove_reference<decltype(ctx.out())>::type;
+        if (detail::has_direct_output<output_t>::value)
+        {
+            int n = fixed_length(x, is_negative, options, fixed_point, trim_trailing_zeros);
+            auto pad = detail::compute_padding(options, options.width, n);
+            size_t total = pad.before + n + pad.after;
+            if (char *out = detail::reserve_direct(ctx.out(), total))
+            {
+                std::fill_n(out, pad.before, options.fill);
+                int written = render(out + pad.before + n, x, is_negative, options, fixed_point, trim_trailing_zeros);
+                assert(written == n);
+                (void)written;
+                std::fill_n(out + pad.before + n, pad.after, options.fill);
+                detail::commit_direct(ctx.out(), out, total);
+                return;
+            }
+        }
+
+        int buf_size = sizeof(T)*8 + 3;
+        if (options.width + 2 > buf_size)
+            buf_size = options.width + 2;
+        if (options.precision + 2 > buf_size)
+            buf_size = options.precision + 2;
+        auto buf_lease = ctx.get_tmp_buffer(buf_size);
+        if (!buf_lease.get())
+            return;
+        char *rbuf = buf_lease.get() + buf_size - 1;
+        int n = render(rbuf, x, is_negative, options, fixed_point, trim_trailing_zeros);
+        auto pad = detail::compute_padding(options, options.width, n);
+        put_fill(ctx.out(), pad.before, options.fill);
+        write(ctx.out(), rbuf - n, n);
+        put_fill(ctx.out(), pad.after, options.fill);
+    }
+
+private:
+    using unsigned_t = typename std::make_unsigned<T>::type;
+
+    /// @brief Writes the number, with sign and leading zeros, right to left, ending before `rbuf`
+    /// @return Number of characters written
+    FORMATPP_CONSTEXPR20 static int render(char *rbuf, unsigned_t x, bool is_negative, const format_options<T> &options,
+                      int fixed_point, bool trim_trailing_zeros)
+    {
+        int n = 0;
         const char *digits = options.digits;
         auto lookup_digit = [digits](int d) { return digits[d]; };
         auto ascii_digit = [](int d) { return '0' + d; };
@@ -1174,27 +1993,108 @@ struct default_formatter<T, IntegralType>
             break;
         }
 
-        while (n < options.precision)
-            rbuf[-++n] = options.digits[0];
+        if (n < options.precision)
+        {
+            std::fill_n(rbuf - options.precision, options.precision - n, options.digits[0]);
+            n = options.precision;
+        }
 
-        if (options.precision != 0 && (rbuf[-n] == '.' || rbuf[-n] == 0))
+        if (options.precision != 0 && (n == 0 || rbuf[-n] == '.'))
             rbuf[-++n] = options.digits[0];
         int space_for_sign = is_negative || options.leading_sign;
-        if (options.leading_char != ' ')
-            while (n < options.width - space_for_sign)
-                rbuf[-++n] = options.leading_char;
+        if (options.leading_char != ' ' && n < options.width - space_for_sign)
+        {
+            int zeros = options.width - space_for_sign - n;
+            std::fill_n(rbuf - n - zeros, zeros, options.leading_char);
+            n += zeros;
+        }
         if (is_negative)
             rbuf[-++n] = '-';
         else if (options.leading_sign)
             rbuf[-++n] = options.leading_sign;
-        while (n < options.width)
-            rbuf[-++n] = ' ';
-        put(ctx.out(), rbuf-n, n);
+        return n;
+    }
+
+    /// @brief The number of characters `render` writes
+    FORMATPP_CONSTEXPR20 static int fixed_length(unsigned_t x, bool is_negative, const format_options<T> &options,
+                            int fixed_point, bool trim_trailing_zeros)
+    {
+        const unsigned radix = options.radix;
+        int n;
+        bool leading_point = false;
+        if (fixed_point > 0)
+        {
+            int trimmed = 0;
+            if (trim_trailing_zeros)
+            {
+                unsigned_t y = x;
+                while (trimmed < fixed_point && y % radix == 0)
+                {
+                    y /= radix;
+                    trimmed++;
+                }
+            }
+            int fraction = fixed_point - trimmed;
+            int integral = std::max(count_digits(x, radix) - fixed_point, 0);
+            n = fraction ? fraction + 1 + integral : integral;
+            leading_point = fraction && !integral;
+        }
+        else
+        {
+            n = count_digits(x, radix);
+        }
+
+        if (n < options.precision)
+        {
+            n = options.precision;
+            leading_point = false;
+        }
+        if (options.precision != 0 && (n == 0 || leading_point))
+            n++;
+        int space_for_sign = is_negative || options.leading_sign;
+        if (options.leading_char != ' ' && n < options.width - space_for_sign)
+            n = options.width - space_for_sign;
+        return n + space_for_sign;
+    }
+
+    /// @brief Number of digits of `x`, none for 0
+    FORMATPP_CONSTEXPR20 static int count_digits(unsigned_t x, unsigned radix)
+    {
+        int n = 0;
+        switch (radix)
+        {
+        case 2:
+        case 4:
+        case 8:
+        case 16:
+        case 32:
+            {
+                int bits = 0;
+                for (; x; x >>= 1)
+                    bits++;
+                int digit_bits = 0;
+                for (unsigned r = radix; r > 1; r >>= 1)
+                    digit_bits++;
+                return (bits + digit_bits - 1) / digit_bits;
+            }
+        case 10:
+            // Compare with powers of 10; no division needed
+            for (unsigned_t p = 1; x >= p; n++)
+            {
+                if (p > std::numeric_limits<unsigned_t>::max() / 10)
+                    return n + 1;
+                p *= 10;
+            }
+            return n;
+        default:
+            for (; x; x /= radix)
+                n++;
+            return n;
+        }
     }
 
-private:
     template <typename radix_type, typename get_digit_fn>
-    static void write_fixed(char *rbuf, typename std::make_unsigned<T>::type x, int &_n,
+    FORMATPP_CONSTEXPR20 static void write_fixed(char *rbuf, typename std::make_unsigned<T>::type x, int &_n,
                             radix_type radix, get_digit_fn get_digit,
                             int fixed_point, bool trim_trailing_zeros)
     {
@@ -1264,16 +2164,12 @@ struct default_formatter<T, FloatingPointType>
         {
             int l = value < 0 || options.leading_sign ? 4 : 3;
             const char *symbol = value < 0 ? "-inf" : options.leading_sign ? "+inf" : "inf";
-            if (options.width > l)
-                put(ctx.out(), options.width - l, ' ');
-            put(ctx.out(), symbol, l);
+            print(ctx, symbol, l, options);
             return true;
         }
         else if (std::isnan(value))
         {
-            if (options.width > 3)
-                put(ctx.out(), options.width - 3, ' ');
-            put(ctx.out(), "nan");
+            print(ctx, "nan", 3, options);
             return true;
         }
 
@@ -1287,6 +2183,9 @@ struct default_formatter<T, FloatingPointType>
             auto tmp = round_value(-value, options, fractional_digits);
             return { -tmp.first, tmp.second };
         }
+        // The exponent of 0 is INT_MIN; nothing to round
+        if (!value)
+            return { value, 0 };
 
         int e = exponent(value, options.radix);
         int precision = options.precision >= 0 ? options.precision : 6;
@@ -1294,7 +2193,10 @@ struct default_formatter<T, FloatingPointType>
         T rem = std::fmod(value, m);
         if (rem > m*T(0.5))
         {
-            value = std::nextafter(value + m -rem, value + m);
+            // Rounding up the largest values would overflow; these are truncated instead
+            T rounded = std::nextafter(value + m -rem, value + m);
+            if (std::isfinite(rounded))
+                value = rounded;
         }
         if (value >= powi(options.radix, e+1))
             e++;
@@ -1340,7 +2242,14 @@ struct default_formatter<T, FloatingPointType>
     static U powi(uint8_t base, int e)
     {
         if (e < 0)
-            return 1.0 / powi<U>(base, -e);
+        {
+            // Below the smallest subnormal for any base
+            if (e < -2 * std::numeric_limits<U>::max_exponent)
+                return 0;
+            // The reciprocal of a power beyond the range can still be (sub)normal: divide by halves
+            U r = powi<U>(base, -e);
+            return std::isinf(r) ? U(1) / powi<U>(base, -e / 2) / powi<U>(base, e / 2 - e) : U(1) / r;
+        }
 
         U result = 1;
         U tmp = base;
@@ -1354,6 +2263,13 @@ struct default_formatter<T, FloatingPointType>
         return result;
     }
 
+    /// @brief `value * base^e`, in two steps if the power alone is out of the normal range
+    static T scale(T value, uint8_t base, int e)
+    {
+        T p = powi(base, e);
+        return std::isnormal(p) ? value * p : value * powi(base, e / 2) * powi(base, e - e / 2);
+    }
+
     template <typename IntegralRepr, typename Context>
     static void positional_impl(Context &ctx, T value, int exponent, const format_options<T> &options, int digits, bool is_auto)
     {
@@ -1364,6 +2280,8 @@ struct default_formatter<T, FloatingPointType>
 
         format_options<IntegralRepr> iopt;
         iopt.width = options.width;
+        iopt.fill = options.fill;
+        iopt.align = options.align;
         iopt.radix = options.radix;
         iopt.leading_sign = options.leading_sign;
         formatter<IntegralRepr>::format_fixed(ctx, ival, iopt, shift, is_auto);
@@ -1374,21 +2292,27 @@ struct default_formatter<T, FloatingPointType>
     {
         auto buf_lease = ctx.get_tmp_buffer(digits + 2);
         char *buf = buf_lease.get();
-        int precision = options.precision ? options.precision : 6;
+        if (!buf)
+            return;
+        int precision = options.precision >= 0 ? options.precision : 6;
         long double epsilon = is_auto ? powi<long double>(options.radix, exponent-digits)
                                       : powi<long double>(options.radix, -precision);
 
         int i = 0;
         int n = exponent > 0 ? exponent : 1;
         if (value < 0)
+        {
             buf[i++] = '-';
+            value = -value;
+        }
         else if (options.leading_sign)
             buf[i++] = '+';
         int e;
         for (e = exponent; e >= 0 && value; e--)
         {
             auto p = powi<long double>(options.radix, e);
-            int d = (int)(value / p);
+            // The quotient can round up to the radix; the remainder is then clamped below
+            int d = std::min((int)(value / p), options.radix - 1);
             value -= d * p;
             if (value < 0)
                 value = 0;
@@ -1447,12 +2371,7 @@ struct default_formatter<T, FloatingPointType>
                 }
             }
         }
-        buf[i++] = 0;
-        if (i < options.width)
-        {
-            put(ctx.out(), options.width - i, ' ');
-        }
-        put(ctx.out(), buf, i);
+        print(ctx, buf, i, options);
     }
     template <typename Context>
     static void positional(Context &ctx, T value, int exponent, const format_options<T> &options, bool is_auto)
@@ -1466,7 +2385,10 @@ struct default_formatter<T, FloatingPointType>
         else if (digits <= detail::max_digits_63[options.radix])
             positional_impl<int64_t>(ctx, value, exponent, options, digits, is_auto);
         else
+        {
+            FORMATPP_STAT_INC(long_double_positional);
             positional_impl_l(ctx, (long double)value, exponent, options, digits, is_auto);
+        }
     }
 
     template <typename Context, typename Exp = int>
@@ -1477,12 +2399,33 @@ struct default_formatter<T, FloatingPointType>
             auto tmp_opt = options;
             tmp_opt.width = 0;
             int precision = options.precision >= 0 ? options.precision : 6;
-            const size_t tmp_n = precision + 8;
+            // Sign, digit, point, digits, `e`, exponent sign and up to 5 exponent digits (`long double`)
+            const size_t tmp_n = precision + 11;
+            // Contiguous outputs: format in place and shift right if padding goes before
+            const size_t max_n = std::max<size_t>(tmp_n, options.width + 1);
+            if (char *out = detail::reserve_direct(ctx.out(), max_n))
+            {
+                char_buf<char> tmp(out, max_n);
+                output_context<char_buf<char>&> tmp_ctx(tmp);
+                scientific(tmp_ctx, value, exponent, tmp_opt, is_auto);
+                size_t len = tmp.size();
+                auto pad = detail::compute_padding(options, options.width, len);
+                if (pad.before)
+                {
+                    std::memmove(out + pad.before, out, len);
+                    std::memset(out, options.fill, pad.before);
+                }
+                std::memset(out + pad.before + len, options.fill, pad.after);
+                detail::commit_direct(ctx.out(), out, pad.before + len + pad.after);
+                return;
+            }
             auto buf_lease = ctx.get_tmp_buffer(tmp_n);
+            if (!buf_lease.get())
+                return;
             char_buf<char> tmp(buf_lease.get(), tmp_n);
             output_context<char_buf<char>&> tmp_ctx(tmp);
             scientific(tmp_ctx, value, exponent, tmp_opt, is_auto);
-            print(ctx, c_str(tmp), string_length(tmp), options.width);
+            print(ctx, c_str(tmp), string_length(tmp), options);
         }
         else
         {
@@ -1493,7 +2436,7 @@ struct default_formatter<T, FloatingPointType>
             }
             else
             {
-                auto tmp = value*powi(options.radix,-exponent);
+                auto tmp = scale(value, options.radix, -exponent);
                 if (std::abs(tmp) < 1)
                     tmp = std::copysign(1, value);
                 positional(ctx, tmp, 0, options, is_auto);
@@ -1511,10 +2454,7 @@ struct default_formatter<T, FloatingPointType>
         static const int32_t endian_test = 1;
         static const bool little_endian = *(const char *)&endian_test == 1;
         const uint8_t *raw = reinterpret_cast<const uint8_t*>(&value);
-        int leading_chars = options.width - 2*sizeof(T);
-        if (leading_chars > 0)
-            put(ctx.out(), leading_chars, ' ');
-        char buf[2*sizeof(T)+1];
+        char buf[2*sizeof(T)];
         int n = 0;
         auto put_hex = [&](uint8_t byte) {
             buf[n++] = options.digits[byte>>4];
@@ -1529,14 +2469,19 @@ struct default_formatter<T, FloatingPointType>
                 put_hex(raw[i]);
             }
         }
-        buf[n++] = 0;
-        put(ctx.out(), buf, n);
+        print(ctx, buf, n, options);
     }
 
     static int exponent(T value, uint8_t radix)
     {
         if (!value)
             return INT_MIN;
+        if (value < std::numeric_limits<T>::min())
+        {
+            // Powers of the radix this small underflow; scale subnormals into the normal range
+            const int shift = std::numeric_limits<T>::digits;
+            return exponent(value * powi(radix, shift), radix) - shift;
+        }
         int bin_exp;
         switch (radix)
         {
@@ -1580,28 +2525,271 @@ struct default_formatter<T, FloatingPointType>
     }
 
     template <typename Context>
-    static void print(Context &ctx, const char *value, int len, int width)
+    static void print(Context &ctx, const char *value, int len, const format_options<T> &options)
     {
-        if (len < width)
-            put(ctx.out(), ' ', width - len);
-        put(ctx.out(), value, len);
+        auto pad = detail::compute_padding(options, options.width, len);
+        put_fill(ctx.out(), pad.before, options.fill);
+        write(ctx.out(), value, len);
+        put_fill(ctx.out(), pad.after, options.fill);
     }
 
 };
 
+namespace detail {
+
+/// @brief Returns the escape sequence for `c` in `buf`, or its length if `buf` is null;
+///        returns 0 if the character doesn't need escaping
+FORMATPP_CONSTEXPR20 inline size_t escape_char(char *buf, unsigned char c, string_escape mode)
+{
+    char simple = 0;
+    switch (c)
+    {
+    case '\\':
+        simple = '\\';
+        break;
+    case '"':
+        if (mode == string_escape::debug)
+            return 0;
+        simple = '"';
+        break;
+    case '\n':
+        simple = 'n';
+        break;
+    case '\r':
+        simple = 'r';
+        break;
+    case '\t':
+        simple = 't';
+        break;
+    case '\b':
+        simple = 'b';
+        break;
+    case '\f':
+        simple = 'f';
+        break;
+    default:
+        if (c >= 0x20 && (c != 0x7f || mode == string_escape::json))
+            return 0;
+        break;
+    }
+
+    if (simple)
+    {
+        if (buf)
+        {
+            buf[0] = '\\';
+            buf[1] = simple;
+        }
+        return 2;
+    }
+
+    if (!buf)
+        return mode == string_escape::json ? 6 : 4;
+
+    const char *hex = integer_format_options::lowercase_digits();
+    switch (mode)
+    {
+    case string_escape::json:
+        buf[0] = '\\';
+        buf[1] = 'u';
+        buf[2] = '0';
+        buf[3] = '0';
+        buf[4] = hex[c >> 4];
+        buf[5] = hex[c & 15];
+        return 6;
+    case string_escape::c:
+        buf[0] = '\\';
+        buf[1] = '0' + (c >> 6);
+        buf[2] = '0' + ((c >> 3) & 7);
+        buf[3] = '0' + (c & 7);
+        return 4;
+    default:
+        buf[0] = '\\';
+        buf[1] = 'x';
+        buf[2] = hex[c >> 4];
+        buf[3] = hex[c & 15];
+        return 4;
+    }
+}
+
+/// @brief Finds the next character which may need escaping in the given mode
+FORMATPP_CONSTEXPR20 inline const char *find_escaped(const char *begin, const char *end, string_escape mode)
+{
+    if (is_constant_evaluated())
+    {
+        for (; begin != end; begin++)
+            if (escape_char(nullptr, *begin, mode))
+                break;
+        return begin;
+    }
+    switch (mode)
+    {
+    case string_escape::json:
+        return simd::find_control_or_any_of(begin, end, '"', '\\', '"');
+    case string_escape::c:
+        return simd::find_control_or_any_of(begin, end, '"', '\\', '\x7f');
+    default:
+        return simd::find_control_or_any_of(begin, end, '\\', '\x7f', '\x7f');
+    }
+}
+
+FORMATPP_CONSTEXPR20 inline size_t escaped_length(const char *str, size_t len, string_escape mode)
+{
+    const char *end = str + len;
+    size_t n = mode == string_escape::c ? len + 2 : len;
+    for (const char *p = find_escaped(str, end, mode); p != end; p = find_escaped(p + 1, end, mode))
+    {
+        if (size_t esc = escape_char(nullptr, *p, mode))
+            n += esc - 1;
+    }
+    return n;
+}
+
+/// @brief Writes a string with escaping; runs which need no escaping are copied in bulk
+template <typename Output>
+FORMATPP_CONSTEXPR20 void write_escaped(Output &out, const char *str, size_t len, string_escape mode)
+{
+    const char *end = str + len;
+    if (mode == string_escape::c)
+        write(out, "\"", 1);
+    for (;;)
+    {
+        const char *p = find_escaped(str, end, mode);
+        if (p == end)
+            break;
+        char buf[8];
+        if (size_t esc = escape_char(buf, *p, mode))
+        {
+            write(out, str, p - str);
+            write(out, buf, esc);
+            str = p + 1;
+        }
+        else
+        {
+            write(out, str, p + 1 - str);
+            str = p + 1;
+        }
+    }
+    write(out, str, end - str);
+    if (mode == string_escape::c)
+        write(out, "\"", 1);
+}
+
+} // detail
+
 template <typename StringLike>
 class default_formatter<StringLike, StringType>
 {
 public:
     template <typename Context>
-    static void format(Context &ctx, const StringLike &value, const format_options<StringLike> &options)
+    FORMATPP_CONSTEXPR20 static void format(Context &ctx, const StringLike &value, const format_options<StringLike> &options)
     {
         int len = string_length(value);
         if (options.precision >= 0 && options.precision < len)
             len = options.precision;
-        if (len < options.width)
-            put(ctx.out(), options.width - len, ' ');
-        put(ctx.out(), value, len);
+        if (options.escape != string_escape::none)
+        {
+            format_escaped(ctx, c_str(value), len, options);
+            return;
+        }
+        string_width unit = options.unit;
+        if (unit == string_width::bytes && measures_code_points<typename std::decay<decltype(ctx.out())>::type>::value)
+            unit = string_width::code_points;
+        if (unit != string_width::bytes)
+        {
+            format_utf8(ctx, c_str(value), string_length(value), unit, options);
+            return;
+        }
+        auto pad = detail::compute_padding(options, options.width, len);
+        put_fill(ctx.out(), pad.before, options.fill);
+        write(ctx.out(), c_str(value), len);
+        put_fill(ctx.out(), pad.after, options.fill);
+    }
+
+private:
+    template <typename Context>
+    static void format_utf8(Context &ctx, const char *str, size_t len, string_width unit, const format_options<StringLike> &options)
+    {
+        if (options.width <= 0 && options.precision < 0)
+        {
+            write(ctx.out(), str, len);
+            return;
+        }
+        size_t limit = options.precision >= 0 ? options.precision : static_cast<size_t>(-1);
+        size_t bytes;
+        size_t width = unicode::measure_utf8(str, len, unit, limit, bytes);
+        auto pad = detail::compute_padding(options, options.width, width);
+        put_fill(ctx.out(), pad.before, options.fill);
+        write(ctx.out(), str, bytes);
+        put_fill(ctx.out(), pad.after, options.fill);
+    }
+
+    template <typename Context>
+    FORMATPP_CONSTEXPR20 static void format_escaped(Context &ctx, const char *str, size_t len, const format_options<StringLike> &options)
+    {
+        detail::padding pad = { 0, 0 };
+        if (options.width > 0)
+            pad = detail::compute_padding(options, options.width, detail::escaped_length(str, len, options.escape));
+        put_fill(ctx.out(), pad.before, options.fill);
+        detail::write_escaped(ctx.out(), str, len, options.escape);
+        put_fill(ctx.out(), pad.after, options.fill);
+    }
+};
+
+template <typename Range>
+struct default_formatter<Range, RangeType>
+{
+    using element_type = range_element_t<Range>;
+
+    template <typename Context>
+    static void format(Context &ctx, const Range &value, const format_options<Range> &options)
+    {
+        if (options.open)
+            write(ctx.out(), &options.open, 1);
+        bool first = true;
+        for (const auto &element : value)
+        {
+            if (!first)
+                write(ctx.out(), options.separator, options.separator_length);
+            first = false;
+            formatter<element_type>::format(ctx, element, options.element);
+        }
+        if (options.close)
+            write(ctx.out(), &options.close, 1);
+    }
+};
+
+template <typename Tuple>
+struct default_formatter<Tuple, TupleType>
+{
+    static constexpr size_t size = std::tuple_size<Tuple>::value;
+
+    template <typename Context>
+    static void format(Context &ctx, const Tuple &value, const format_options<Tuple> &options)
+    {
+        if (options.brackets)
+            write(ctx.out(), "(", 1);
+        format_elements(ctx, value, options, std::integral_constant<size_t, 0>());
+        if (options.brackets)
+            write(ctx.out(), ")", 1);
+    }
+
+private:
+    template <typename Context>
+    static void format_elements(Context &, const Tuple &, const format_options<Tuple> &,
+                                std::integral_constant<size_t, size>)
+    {
+    }
+
+    template <typename Context, size_t index>
+    static void format_elements(Context &ctx, const Tuple &value, const format_options<Tuple> &options,
+                                std::integral_constant<size_t, index>)
+    {
+        using element_type = typename std::decay<typename std::tuple_element<index, Tuple>::type>::type;
+        if (index > 0)
+            write(ctx.out(), options.separator, options.separator_length);
+        formatter<element_type>::format(ctx, std::get<index>(value), {});
+        format_elements(ctx, value, options, std::integral_constant<size_t, index + 1>());
     }
 };
 
@@ -1614,10 +2802,10 @@ struct format_param;
 template <typename Context>
 struct format_param_base
 {
-    virtual ~format_param_base() = default;
+    virtual FORMATPP_CONSTEXPR20 ~format_param_base() = default;
 
-    virtual void format(Context &context, const char *format_str, size_t &format_index) const = 0;
-    virtual void format(Context &context) const = 0;
+    virtual FORMATPP_CONSTEXPR20 void format(Context &context, const char *format_str, size_t &format_index) const = 0;
+    virtual FORMATPP_CONSTEXPR20 void format(Context &context) const = 0;
 
     template <typename T>
     T &value()
@@ -1629,31 +2817,34 @@ struct format_param_base
 template <typename Context, typename T>
 struct format_param : format_param_base<Context>
 {
-    format_param(T v) : value(std::forward<T>(v)) {}
+    FORMATPP_CONSTEXPR20 format_param(T v) : value(std::forward<T>(v)) {}
+    FORMATPP_CONSTEXPR20 ~format_param() override {}
     T value;
-    using formatted_type = typename std::remove_reference<T>::type;
+    using formatted_type = typename std::remove_cv<typename std::remove_reference<T>::type>::type;
 
-    void format(Context &context, const char *format_str, size_t &format_index) const override
+    FORMATPP_CONSTEXPR20 void format(Context &context, const char *format_str, size_t &format_index) const override
     {
         format_options<formatted_type> opt(format_str, format_index);
+        if (detail::failed())
+            return;
         formatter<formatted_type>::format(context, value, opt);
     }
 
-    void format(Context &context) const override
+    FORMATPP_CONSTEXPR20 void format(Context &context) const override
     {
         formatter<formatted_type>::format(context, value, {});
     }
 };
 
 template <size_t index, typename T, typename...Args>
-void get_tuple_addresses(T *array[], std::tuple<Args...> &tuple,
+FORMATPP_CONSTEXPR20 void get_tuple_addresses(T *array[], std::tuple<Args...> &tuple,
                         std::integral_constant<size_t, index>, std::integral_constant<size_t, 1>)
 {
     array[index] = &std::get<index>(tuple);
 }
 
 template <size_t begin, size_t count, typename T, typename...Args>
-void get_tuple_addresses(T *array[], std::tuple<Args...> &tuple,
+FORMATPP_CONSTEXPR20 void get_tuple_addresses(T *array[], std::tuple<Args...> &tuple,
                         std::integral_constant<size_t, begin>, std::integral_constant<size_t, count>)
 {
     constexpr size_t n1 = count/2;
@@ -1663,7 +2854,7 @@ void get_tuple_addresses(T *array[], std::tuple<Args...> &tuple,
 }
 
 template <typename T, typename...Args>
-void get_tuple_addresses(T *array[], std::tuple<Args...> &tuple)
+FORMATPP_CONSTEXPR20 void get_tuple_addresses(T *array[], std::tuple<Args...> &tuple)
 {
     get_tuple_addresses(array, tuple, std::integral_constant<size_t, 0>(), std::integral_constant<size_t, sizeof...(Args)>());
 }
@@ -1676,7 +2867,7 @@ public:
     format_params() = default;
     static constexpr size_t N = sizeof...(Args);
 
-    format_params(Args&&... args)
+    FORMATPP_CONSTEXPR20 format_params(Args&&... args)
     : storage(format_param<Context, Args>(std::forward<Args>(args))...)
     {
         get_tuple_addresses(params, storage);
@@ -1684,7 +2875,7 @@ public:
 
     static constexpr size_t size() { return N; }
 
-    format_param_base<Context> &operator[](size_t index) const noexcept
+    FORMATPP_CONSTEXPR20 format_param_base<Context> &operator[](size_t index) const noexcept
     {
         return *params[index];
     }
@@ -1702,17 +2893,43 @@ public:
 
     format_param_base<Context> &operator[](size_t index) const
     {
+#ifdef FORMATPP_NO_EXCEPTIONS
+        std::abort();  // vformat checks the index first
+#else
         throw std::logic_error("Trying to get a value from an empty argument list");
+#endif
     }
 };
 
 template <typename Context, typename... Args>
-format_params<Context, Args...> make_format_params(Args&&... args)
+FORMATPP_CONSTEXPR20 format_params<Context, Args...> make_format_params(Args&&... args)
 {
     return { std::forward<Args>(args)... };
 }
 
-inline int parse_index(const char *s, size_t &i)
+/// @brief Arguments whose number and types are only known at run time, e.g. calls replayed from a capture
+template <typename Context>
+class dynamic_format_params
+{
+public:
+    template <typename T>
+    void push_back(T value)
+    {
+        params.emplace_back(new format_param<Context, T>(std::move(value)));
+    }
+
+    size_t size() const noexcept { return params.size(); }
+
+    format_param_base<Context> &operator[](size_t index) const noexcept
+    {
+        return *params[index];
+    }
+
+private:
+    std::vector<std::unique_ptr<format_param_base<Context>>> params;
+};
+
+FORMATPP_CONSTEXPR20 inline int parse_index(const char *s, size_t &i)
 {
     int index = -1;
     for (;; i++)
@@ -1728,16 +2945,17 @@ inline int parse_index(const char *s, size_t &i)
         else if (c == ':' || c == '}')
             break;
         else
-            throw std::logic_error("Invalid format string");
+            FORMATPP_FAIL_RETURN(invalid_format_string, std::logic_error("Invalid format string"), -1);
     }
     return index;
 }
 
-template <typename Context, typename FormatString, typename... Args>
-void vformat(Context &ctx, const FormatString &format, const format_params<Context, Args...> &params)
+namespace detail {
+
+template <typename Context, typename Params>
+FORMATPP_CONSTEXPR20 format_errc vformat_impl(Context &ctx, const char *s, size_t len, const Params &params)
 {
-    size_t len = string_length(format);
-    const char *s = c_str(format);
+    clear_error();
 
     int last_idx = -1;
     size_t start = 0;
@@ -1760,9 +2978,13 @@ void vformat(Context &ctx, const FormatString &format, const format_params<Conte
                 int explicit_idx = parse_index(s, i);
                 if (explicit_idx >= 0)
                     index = last_idx = explicit_idx;
+                else if (detail::failed())
+                    return last_error();
 
                 if (index < 0 || index >= N)
-                    throw std::out_of_range("Argument index out of range: " + std::to_string(index));
+                    FORMATPP_FAIL_RETURN(argument_index_out_of_range,
+                        std::out_of_range("Argument index out of range: " + std::to_string(index)),
+                        last_error());
 
                 if (s[i] == ':')
                 {
@@ -1771,12 +2993,14 @@ void vformat(Context &ctx, const FormatString &format, const format_params<Conte
                 }
                 else
                     params[index].format(ctx);
-
+                if (detail::failed())
+                    return last_error();
 
                 while (s[i] != '}')
                 {
                     if (!s[i])
-                        throw std::logic_error("Missing closing brace in a format specfier");
+                        FORMATPP_FAIL_RETURN(invalid_format_string,
+                            std::logic_error("Missing closing brace in a format specfier"), last_error());
                     i++;
                 }
                 start = i+1;
@@ -1792,41 +3016,102 @@ void vformat(Context &ctx, const FormatString &format, const format_params<Conte
         }
     }
     put(ctx.out(), s + start, len - start);
+    return last_error();
+}
+
+/// The profiler's timer is kept out of `vformat_impl`, which runs in constant evaluation
+template <typename Context, typename Params>
+format_errc vformat_profiled(Context &ctx, const char *s, size_t len, const Params &params)
+{
+    FORMATPP_PROFILE_CALL(s, len);
+    return vformat_impl(ctx, s, len, params);
+}
+
+} // detail
+
+/// @brief Formats with `format_params` or `dynamic_format_params`
+///
+/// @return `format_errc::ok`, or the error code if the library is built with `FORMATPP_NO_EXCEPTIONS`;
+///         the output is then incomplete
+template <typename Context, typename FormatString, typename Params>
+FORMATPP_CONSTEXPR20 format_errc vformat(Context &ctx, const FormatString &format, const Params &params)
+{
+    if (detail::is_constant_evaluated())
+        return detail::vformat_impl(ctx, c_str(format), string_length(format), params);
+    return detail::vformat_profiled(ctx, c_str(format), string_length(format), params);
 }
 
 template <typename Output, typename FormatString, typename... Args>
-void format_to(output_context<Output> &context, const FormatString &format_string, Args&&... args)
+FORMATPP_CONSTEXPR20 format_errc format_to(output_context<Output> &context, const FormatString &format_string, Args&&... args)
 {
+    FORMATPP_CAPTURE_CALL(c_str(format_string), string_length(format_string), args...);
     return vformat(context, format_string,
                    make_format_params<output_context<Output>>(std::forward<Args>(args)...));
 }
 
 template <typename Output, typename FormatString, typename... Args>
-void format_to(Output &out, const FormatString &format_string, Args&&... args)
+FORMATPP_CONSTEXPR20 format_errc format_to(Output &out, const FormatString &format_string, Args&&... args)
 {
     output_context<Output &> ctx(out);
-    format_to(ctx, format_string, std::forward<Args>(args)...);
+    return format_to(ctx, format_string, std::forward<Args>(args)...);
+}
+
+#ifdef FORMATPP_SIZE_HINTS
+namespace detail {
+
+template <typename FormatString, typename... Args>
+format_errc format_to_predicted(std::string &out, const FormatString &format_string, Args&&... args)
+{
+    size_hint::detail::prediction prediction(out, c_str(format_string));
+    output_context<std::string &> ctx(out);
+    format_errc e = format_to(ctx, format_string, std::forward<Args>(args)...);
+    prediction.update(out);
+    return e;
+}
+
+} // detail
+
+/// @brief Reserves the length predicted for `format_string` before formatting (see `size_hint`)
+template <typename FormatString, typename... Args>
+FORMATPP_CONSTEXPR20 format_errc format_to(std::string &out, const FormatString &format_string, Args&&... args)
+{
+    if (detail::is_constant_evaluated())
+    {
+        output_context<std::string &> ctx(out);
+        return format_to(ctx, format_string, std::forward<Args>(args)...);
+    }
+    return detail::format_to_predicted(out, format_string, std::forward<Args>(args)...);
 }
+#endif
 
 template <typename FormatString, typename... Args>
-std::string format_str(const FormatString &format_string, Args&&... args)
+FORMATPP_CONSTEXPR20 std::string format_str(const FormatString &format_string, Args&&... args)
 {
     std::string str;
     format_to(str, format_string, std::forward<Args>(args)...);
     return str;
 }
 
+/// @brief Calculates the length of the formatted string without writing it anywhere
+template <typename FormatString, typename... Args>
+FORMATPP_CONSTEXPR20 size_t formatted_size(const FormatString &format_string, Args&&... args)
+{
+    counting_sink counter;
+    format_to(counter, format_string, std::forward<Args>(args)...);
+    return counter.count;
+}
+
 template <typename FormatString, typename... Args>
-void print(const FormatString &format_string, Args&&... args)
+format_errc print(const FormatString &format_string, Args&&... args)
 {
-    format_to(std::cout, format_string, std::forward<Args>(args)...);
+    return format_to(std::cout, format_string, std::forward<Args>(args)...);
 }
 
 template <typename FormatString, typename... Args>
-void vprint(const FormatString &format_string, const format_params<ostream_output_context, Args...> &params)
+format_errc vprint(const FormatString &format_string, const format_params<ostream_output_context, Args...> &params)
 {
     ostream_output_context ctx(std::cout);
-    vformat(ctx, format_string, params);
+    return vformat(ctx, format_string, params);
 }
 
 } // formatpp
@@ -0,0 +1,297 @@
+#ifndef FORMATPP_NET_H_
+#define FORMATPP_NET_H_
+
+#include "format.h"
+#include "simd.h"
+#include <cstdint>
+
+namespace formatpp {
+
+/// @brief IPv4 address, stored in network byte order
+struct ipv4_address
+{
+    ipv4_address() = default;
+    explicit ipv4_address(const uint8_t (&b)[4])
+    {
+        std::memcpy(bytes, b, 4);
+    }
+    /// @param host_order  address in host byte order, e.g. 0x7f000001 for 127.0.0.1
+    explicit ipv4_address(uint32_t host_order)
+    {
+        bytes[0] = host_order >> 24;
+        bytes[1] = host_order >> 16;
+        bytes[2] = host_order >> 8;
+        bytes[3] = host_order;
+    }
+
+    uint8_t bytes[4] = {};
+};
+
+/// @brief IPv6 address, stored in network byte order
+struct ipv6_address
+{
+    ipv6_address() = default;
+    explicit ipv6_address(const uint8_t (&b)[16])
+    {
+        std::memcpy(bytes, b, 16);
+    }
+
+    uint8_t bytes[16] = {};
+};
+
+struct uuid
+{
+    uuid() = default;
+    explicit uuid(const uint8_t (&b)[16])
+    {
+        std::memcpy(bytes, b, 16);
+    }
+
+    uint8_t bytes[16] = {};
+};
+
+struct mac_address
+{
+    mac_address() = default;
+    explicit mac_address(const uint8_t (&b)[6])
+    {
+        std::memcpy(bytes, b, 6);
+    }
+
+    uint8_t bytes[6] = {};
+};
+
+/// @brief Options for formatting network addresses and identifiers
+///
+/// Syntax: `[[fill]align][width][x|X][-]`; `X` selects uppercase hex digits, `-` selects a dash
+/// instead of a colon as the MAC address separator.
+struct identifier_format_options : align_options
+{
+    void parse(const char *options, size_t &i)
+    {
+        parse_align(options, i);
+        char c;
+        while (is_ascii_digit(c = options[i]))
+        {
+            width = 10*width + (c - '0');
+            i++;
+        }
+        switch (options[i])
+        {
+        case 'x':
+            digits = integer_format_options::lowercase_digits();
+            i++;
+            break;
+        case 'X':
+            digits = integer_format_options::uppercase_digits();
+            i++;
+            break;
+        }
+        if (options[i] == '-')
+        {
+            separator = '-';
+            i++;
+        }
+        if (options[i] != '}' && options[i] != '\0')
+            FORMATPP_FAIL(invalid_specifier, std::runtime_error(std::string("Invalid format specifier for an identifier: ") + options));
+    }
+
+    int width = 0;
+    const char *digits = integer_format_options::lowercase_digits();
+    char separator = ':';
+};
+
+template <>
+struct default_format_options<ipv4_address, void> : identifier_format_options
+{};
+
+template <>
+struct default_format_options<ipv6_address, void> : identifier_format_options
+{};
+
+template <>
+struct default_format_options<uuid, void> : identifier_format_options
+{};
+
+template <>
+struct default_format_options<mac_address, void> : identifier_format_options
+{};
+
+namespace detail {
+
+template <typename Context>
+void put_identifier(Context &ctx, const char *buf, size_t len, const identifier_format_options &options)
+{
+    auto pad = compute_padding(options, options.width, len);
+    put_fill(ctx.out(), pad.before, options.fill);
+    write(ctx.out(), buf, len);
+    put_fill(ctx.out(), pad.after, options.fill);
+}
+
+/// @brief Writes a decimal octet (0-255) using a lookup table; returns the number of characters
+inline int write_octet(char *dst, uint8_t x)
+{
+    struct octet_table
+    {
+        octet_table()
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                char *p = text[i];
+                if (i >= 100)
+                    *p++ = '0' + i / 100;
+                if (i >= 10)
+                    *p++ = '0' + i / 10 % 10;
+                *p++ = '0' + i % 10;
+                length[i] = p - text[i];
+            }
+        }
+        char text[256][4];
+        uint8_t length[256];
+    };
+    static const octet_table table;
+    std::memcpy(dst, table.text[x], 4);
+    return table.length[x];
+}
+
+inline int write_ipv4(char *dst, const uint8_t *bytes)
+{
+    char *p = dst;
+    for (int i = 0; i < 4; i++)
+    {
+        if (i)
+            *p++ = '.';
+        p += write_octet(p, bytes[i]);
+    }
+    return p - dst;
+}
+
+/// @brief Writes a 16-bit group in hex, without leading zeros
+inline int write_hex_group(char *dst, unsigned group, const char *digits)
+{
+    int n = group >= 0x1000 ? 4 : group >= 0x100 ? 3 : group >= 0x10 ? 2 : 1;
+    for (int i = n - 1; i >= 0; i--)
+    {
+        dst[i] = digits[group & 15];
+        group >>= 4;
+    }
+    return n;
+}
+
+} // detail
+
+template <>
+struct formatter<ipv4_address>
+{
+    template <typename Context>
+    static void format(Context &ctx, const ipv4_address &value, const format_options<ipv4_address> &options)
+    {
+        char buf[16];
+        int n = detail::write_ipv4(buf, value.bytes);
+        detail::put_identifier(ctx, buf, n, options);
+    }
+};
+
+/// @brief Formats IPv6 addresses in the RFC 5952 canonical form
+///
+/// The longest run of two or more zero groups is replaced with `::`, and IPv4-mapped
+/// addresses are printed in mixed notation, e.g. `::ffff:192.0.2.1`.
+template <>
+struct formatter<ipv6_address>
+{
+    template <typename Context>
+    static void format(Context &ctx, const ipv6_address &value, const format_options<ipv6_address> &options)
+    {
+        unsigned groups[8];
+        for (int i = 0; i < 8; i++)
+            groups[i] = value.bytes[2*i] << 8 | value.bytes[2*i + 1];
+
+        int best_start = -1, best_len = 1;
+        for (int i = 0; i < 8;)
+        {
+            if (groups[i])
+            {
+                i++;
+                continue;
+            }
+            int start = i;
+            while (i < 8 && !groups[i])
+                i++;
+            if (i - start > best_len)
+            {
+                best_start = start;
+                best_len = i - start;
+            }
+        }
+
+        bool ipv4_mapped = best_start == 0 && best_len == 5 && groups[5] == 0xffff;
+
+        char buf[48];
+        char *p = buf;
+        int hex_groups = ipv4_mapped ? 6 : 8;
+        for (int i = 0; i < hex_groups; i++)
+        {
+            if (i == best_start)
+            {
+                *p++ = ':';
+                if (i == 0)
+                    *p++ = ':';
+                i += best_len - 1;
+                continue;
+            }
+            p += detail::write_hex_group(p, groups[i], options.digits);
+            if (i < 7)
+                *p++ = ':';
+        }
+        if (ipv4_mapped)
+            p += detail::write_ipv4(p, value.bytes + 12);
+        detail::put_identifier(ctx, buf, p - buf, options);
+    }
+};
+
+template <>
+struct formatter<uuid>
+{
+    template <typename Context>
+    static void format(Context &ctx, const uuid &value, const format_options<uuid> &options)
+    {
+        char hex[32];
+        simd::hex_encode(hex, value.bytes, 16, options.digits);
+        // 8-4-4-4-12
+        char buf[36];
+        std::memcpy(buf, hex, 8);
+        buf[8] = '-';
+        std::memcpy(buf + 9, hex + 8, 4);
+        buf[13] = '-';
+        std::memcpy(buf + 14, hex + 12, 4);
+        buf[18] = '-';
+        std::memcpy(buf + 19, hex + 16, 4);
+        buf[23] = '-';
+        std::memcpy(buf + 24, hex + 20, 12);
+        detail::put_identifier(ctx, buf, sizeof(buf), options);
+    }
+};
+
+template <>
+struct formatter<mac_address>
+{
+    template <typename Context>
+    static void format(Context &ctx, const mac_address &value, const format_options<mac_address> &options)
+    {
+        char hex[12];
+        simd::hex_encode(hex, value.bytes, 6, options.digits);
+        char buf[17];
+        for (int i = 0; i < 6; i++)
+        {
+            buf[3*i] = hex[2*i];
+            buf[3*i + 1] = hex[2*i + 1];
+            if (i < 5)
+                buf[3*i + 2] = options.separator;
+        }
+        detail::put_identifier(ctx, buf, sizeof(buf), options);
+    }
+};
+
+} // formatpp
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef FORMATPP_POOL_H_
+#define FORMATPP_POOL_H_
+
+#include "format.h"
+#include <mutex>
+#include <string>
+
+namespace formatpp {
+
+class string_pool;
+
+namespace detail {
+
+struct pool_node
+{
+    std::string str;
+    pool_node *next = nullptr;
+};
+
+} // detail
+
+/// @brief A string borrowed from a `string_pool`, returned to it (with its capacity) on destruction
+///
+/// Move-only; can be handed over to another thread, which then releases it.
+class pooled_string
+{
+public:
+    pooled_string() = default;
+    pooled_string(const pooled_string &) = delete;
+    pooled_string &operator=(const pooled_string &) = delete;
+
+    pooled_string(pooled_string &&other) noexcept : pool(other.pool), node(other.node)
+    {
+        other.pool = nullptr;
+        other.node = nullptr;
+    }
+
+    pooled_string &operator=(pooled_string &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            pool = other.pool;
+            node = other.node;
+            other.pool = nullptr;
+            other.node = nullptr;
+        }
+        return *this;
+    }
+
+    ~pooled_string()
+    {
+        reset();
+    }
+
+    /// @brief Returns the string to the pool
+    void reset() noexcept;
+
+    explicit operator bool() const noexcept { return node != nullptr; }
+
+    std::string &str() noexcept { return node->str; }
+    const std::string &str() const noexcept { return node->str; }
+    std::string *operator->() noexcept { return &node->str; }
+    const std::string *operator->() const noexcept { return &node->str; }
+    const char *c_str() const noexcept { return node->str.c_str(); }
+    const char *data() const noexcept { return node->str.data(); }
+    size_t size() const noexcept { return node->str.size(); }
+
+private:
+    friend class string_pool;
+    pooled_string(string_pool *pool, detail::pool_node *node) : pool(pool), node(node) {}
+
+    string_pool *pool = nullptr;
+    detail::pool_node *node = nullptr;
+};
+
+/// @brief A free list of strings which keep their capacity between uses
+///
+/// Once the pool has warmed up, formatting into a pooled string and releasing it, on any thread,
+/// doesn't touch the heap. The free list is guarded by a mutex held only to push or pop one pointer.
+/// Strings that grew beyond `max_capacity`, or released when `max_free` strings are already
+/// free, are deallocated. All pooled strings must be released before the pool is destroyed.
+class string_pool
+{
+public:
+    static constexpr size_t default_max_free = 1024;
+    static constexpr size_t default_max_capacity = 1 << 16;
+
+    explicit string_pool(size_t max_free = default_max_free, size_t max_capacity = default_max_capacity)
+    : max_free(max_free), max_capacity(max_capacity)
+    {
+    }
+
+    string_pool(const string_pool &) = delete;
+    string_pool &operator=(const string_pool &) = delete;
+
+    ~string_pool()
+    {
+        while (head)
+        {
+            node *n = head;
+            head = n->next;
+            delete n;
+        }
+    }
+
+    /// @brief An empty string, reused if there's one available
+    pooled_string acquire()
+    {
+        node *n = nullptr;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (head)
+            {
+                n = head;
+                head = n->next;
+                num_free--;
+            }
+        }
+        if (!n)
+            n = new node();
+        return { this, n };
+    }
+
+    /// @brief Creates `count` strings with `capacity` reserved, so that the first uses don't allocate
+    void preallocate(size_t count, size_t capacity)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            node *n = new node();
+            n->str.reserve(capacity);
+            release(n);
+        }
+    }
+
+    size_t free_count() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return num_free;
+    }
+
+private:
+    friend class pooled_string;
+    using node = detail::pool_node;
+
+    void release(node *n) noexcept
+    {
+        if (n->str.capacity() <= max_capacity)
+        {
+            n->str.clear();
+            std::lock_guard<std::mutex> guard(lock);
+            if (num_free < max_free)
+            {
+                n->next = head;
+                head = n;
+                num_free++;
+                return;
+            }
+        }
+        delete n;
+    }
+
+    mutable std::mutex lock;
+    node *head = nullptr;
+    size_t num_free = 0;
+    size_t max_free, max_capacity;
+};
+
+inline void pooled_string::reset() noexcept
+{
+    if (node)
+    {
+        pool->release(node);
+        pool = nullptr;
+        node = nullptr;
+    }
+}
+
+/// @brief The pool used by `format_pooled` without an explicit pool; never destroyed
+inline string_pool &default_string_pool()
+{
+    static string_pool *pool = new string_pool();
+    return *pool;
+}
+
+/// @brief Formats into a string from `pool`: `auto msg = format_pooled(pool, "{}: {}", key, value);`
+template <typename FormatString, typename... Args>
+pooled_string format_pooled(string_pool &pool, const FormatString &format_string, Args&&... args)
+{
+    pooled_string str = pool.acquire();
+    format_to(str.str(), format_string, std::forward<Args>(args)...);
+    return str;
+}
+
+template <typename FormatString, typename... Args>
+pooled_string format_pooled(const FormatString &format_string, Args&&... args)
+{
+    return format_pooled(default_string_pool(), format_string, std::forward<Args>(args)...);
+}
+
+} // formatpp
+
+#endif
@@ -0,0 +1,380 @@
+#ifndef FORMATPP_PROFILE_H_
+#define FORMATPP_PROFILE_H_
+
+#include "stats.h"
+#include <cstddef>
+#include <cstdint>
+
+#ifdef FORMATPP_PROFILE
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#endif
+
+namespace formatpp {
+
+namespace profile {
+
+#ifdef FORMATPP_PROFILE
+
+constexpr bool enabled = true;
+
+/// @brief Aggregated cost of one format string
+struct entry
+{
+    /// The format string, truncated to `max_text` characters
+    std::string text;
+    uint64_t calls = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    uint64_t bytes = 0;
+};
+
+namespace detail {
+
+enum : size_t
+{
+    table_size = 1024,
+    max_text = 63
+};
+
+/// One call site. Only the owning thread writes the counters; the key and text are set once.
+struct slot
+{
+    std::atomic<const char *> key;
+    std::atomic<uint64_t> calls, total_ns, max_ns, bytes;
+    char text[max_text + 1];
+};
+
+inline void bump(std::atomic<uint64_t> &v, uint64_t n)
+{
+    v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline const char *overflow_key()
+{
+    static const char key[] = "(other format strings)";
+    return key;
+}
+
+struct thread_table;
+
+struct registry
+{
+    std::mutex lock;
+    thread_table *threads = nullptr;
+    /// Entries of the threads that have exited
+    std::unordered_map<const char *, entry> retired;
+
+    static registry &instance()
+    {
+        static registry r;
+        return r;
+    }
+
+    ~registry();
+};
+
+/// @brief Per-thread open-addressing table keyed by the address of the format string
+///
+/// Call sites that don't fit are accumulated in a single overflow slot.
+struct thread_table
+{
+    std::unique_ptr<slot[]> slots;
+    slot overflow;
+    /// Bytes written by this thread, across all sinks
+    uint64_t bytes = 0;
+    thread_table *prev = nullptr, *next = nullptr;
+
+    thread_table() : slots(new slot[table_size])
+    {
+        for (size_t i = 0; i < table_size; i++)
+            clear(slots[i]);
+        clear(overflow);
+        set_text(overflow, overflow_key(), std::strlen(overflow_key()));
+        overflow.key.store(overflow_key(), std::memory_order_relaxed);
+        registry &r = registry::instance();
+        std::lock_guard<std::mutex> guard(r.lock);
+        next = r.threads;
+        if (next)
+            next->prev = this;
+        r.threads = this;
+    }
+
+    ~thread_table();
+
+    static void clear(slot &s)
+    {
+        s.key.store(nullptr, std::memory_order_relaxed);
+        s.calls.store(0, std::memory_order_relaxed);
+        s.total_ns.store(0, std::memory_order_relaxed);
+        s.max_ns.store(0, std::memory_order_relaxed);
+        s.bytes.store(0, std::memory_order_relaxed);
+        s.text[0] = 0;
+    }
+
+    static void set_text(slot &s, const char *str, size_t len)
+    {
+        len = std::min<size_t>(len, max_text);
+        std::memcpy(s.text, str, len);
+        s.text[len] = 0;
+    }
+
+    slot &find(const char *key, size_t len)
+    {
+        size_t h = static_cast<size_t>((reinterpret_cast<uintptr_t>(key) >> 3) * 0x9E3779B97F4A7C15ull);
+        for (size_t probe = 0; probe < 8; probe++)
+        {
+            slot &s = slots[(h + probe) & (table_size - 1)];
+            const char *k = s.key.load(std::memory_order_relaxed);
+            if (k == key)
+                return s;
+            if (!k)
+            {
+                set_text(s, key, len);
+                s.key.store(key, std::memory_order_release);
+                return s;
+            }
+        }
+        return overflow;
+    }
+
+    void record(const char *key, size_t len, uint64_t ns, uint64_t out_bytes)
+    {
+        slot &s = find(key, len);
+        bump(s.calls, 1);
+        bump(s.total_ns, ns);
+        bump(s.bytes, out_bytes);
+        if (ns > s.max_ns.load(std::memory_order_relaxed))
+            s.max_ns.store(ns, std::memory_order_relaxed);
+    }
+
+    /// Adds the slots to `out`; the registry lock must be held
+    void merge_into(std::unordered_map<const char *, entry> &out) const
+    {
+        merge_slot(overflow, out);
+        for (size_t i = 0; i < table_size; i++)
+            merge_slot(slots[i], out);
+    }
+
+    static void merge_slot(const slot &s, std::unordered_map<const char *, entry> &out)
+    {
+        const char *key = s.key.load(std::memory_order_acquire);
+        uint64_t calls = s.calls.load(std::memory_order_relaxed);
+        if (!key || !calls)
+            return;
+        entry &e = out[key];
+        if (e.text.empty())
+            e.text = s.text;
+        e.calls += calls;
+        e.total_ns += s.total_ns.load(std::memory_order_relaxed);
+        e.max_ns = std::max(e.max_ns, s.max_ns.load(std::memory_order_relaxed));
+        e.bytes += s.bytes.load(std::memory_order_relaxed);
+    }
+
+    void reset()
+    {
+        for (size_t i = 0; i < table_size; i++)
+        {
+            slots[i].calls.store(0, std::memory_order_relaxed);
+            slots[i].total_ns.store(0, std::memory_order_relaxed);
+            slots[i].max_ns.store(0, std::memory_order_relaxed);
+            slots[i].bytes.store(0, std::memory_order_relaxed);
+        }
+        overflow.calls.store(0, std::memory_order_relaxed);
+        overflow.total_ns.store(0, std::memory_order_relaxed);
+        overflow.max_ns.store(0, std::memory_order_relaxed);
+        overflow.bytes.store(0, std::memory_order_relaxed);
+    }
+};
+
+inline thread_table::~thread_table()
+{
+    registry &r = registry::instance();
+    std::lock_guard<std::mutex> guard(r.lock);
+    merge_into(r.retired);
+    if (prev)
+        prev->next = next;
+    else
+        r.threads = next;
+    if (next)
+        next->prev = prev;
+}
+
+/// Format strings are printed as C literals
+inline std::string escape(const std::string &text)
+{
+    std::string out;
+    for (char c : text)
+    {
+        switch (c)
+        {
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        case '\r': out += "\\r"; break;
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\x%02x", static_cast<unsigned char>(c));
+                out += buf;
+            }
+            else
+                out += c;
+        }
+    }
+    return out;
+}
+
+inline thread_table &this_thread()
+{
+    static thread_local thread_table table;
+    return table;
+}
+
+inline void add_bytes(uint64_t n)
+{
+    this_thread().bytes += n;
+}
+
+/// @brief Times one `vformat` call and attributes it, with the bytes written, to its format string
+class call_scope
+{
+public:
+    call_scope(const char *format, size_t len)
+    : table(this_thread()), format(format), len(len), bytes(table.bytes),
+      start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~call_scope()
+    {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        table.record(format, len, static_cast<uint64_t>(ns), table.bytes - bytes);
+    }
+
+private:
+    thread_table &table;
+    const char *format;
+    size_t len;
+    uint64_t bytes;
+    std::chrono::steady_clock::time_point start;
+};
+
+} // detail
+
+/// @brief The entries of all threads, including the ones that have exited, merged by format string
+/// and sorted by total time, most expensive first
+inline std::vector<entry> collect()
+{
+    std::unordered_map<const char *, entry> merged;
+    {
+        detail::registry &r = detail::registry::instance();
+        std::lock_guard<std::mutex> guard(r.lock);
+        merged = r.retired;
+        for (detail::thread_table *t = r.threads; t; t = t->next)
+            t->merge_into(merged);
+    }
+    std::vector<entry> entries;
+    entries.reserve(merged.size());
+    for (auto &kv : merged)
+        entries.push_back(std::move(kv.second));
+    std::sort(entries.begin(), entries.end(), [](const entry &a, const entry &b)
+    {
+        return a.total_ns > b.total_ns;
+    });
+    return entries;
+}
+
+/// @brief Zeroes all entries; the captured format strings are kept
+inline void reset()
+{
+    detail::registry &r = detail::registry::instance();
+    std::lock_guard<std::mutex> guard(r.lock);
+    r.retired.clear();
+    for (detail::thread_table *t = r.threads; t; t = t->next)
+        t->reset();
+}
+
+/// @brief Prints the `max_entries` most expensive format strings (all if 0) as a table
+inline void report(std::FILE *out, size_t max_entries = 0)
+{
+    std::vector<entry> entries = collect();
+    if (max_entries && entries.size() > max_entries)
+        entries.resize(max_entries);
+    std::fprintf(out, "%12s %14s %10s %10s %12s  %s\n", "calls", "total ns", "avg ns", "max ns", "bytes", "format");
+    for (const entry &e : entries)
+    {
+        std::fprintf(out, "%12llu %14llu %10llu %10llu %12llu  \"%s\"\n",
+                     static_cast<unsigned long long>(e.calls),
+                     static_cast<unsigned long long>(e.total_ns),
+                     static_cast<unsigned long long>(e.total_ns / e.calls),
+                     static_cast<unsigned long long>(e.max_ns),
+                     static_cast<unsigned long long>(e.bytes),
+                     detail::escape(e.text).c_str());
+    }
+}
+
+/// At exit, the report is written to the file named by `FORMATPP_PROFILE_REPORT` (or stderr, for `-`)
+inline detail::registry::~registry()
+{
+    const char *path = std::getenv("FORMATPP_PROFILE_REPORT");
+    if (!path || !*path)
+        return;
+    std::FILE *f = std::strcmp(path, "-") ? std::fopen(path, "w") : stderr;
+    if (!f)
+        return;
+    // Threads still running at exit are reported as they are now
+    for (thread_table *t = threads; t; t = t->next)
+        t->merge_into(retired);
+    threads = nullptr;
+    report(f);
+    if (f != stderr)
+        std::fclose(f);
+}
+
+#define FORMATPP_PROFILE_CALL(format, len) ::formatpp::profile::detail::call_scope formatpp_profile_scope_(format, len)
+
+#else
+
+constexpr bool enabled = false;
+
+#define FORMATPP_PROFILE_CALL(format, len) ((void)0)
+
+#endif
+
+} // profile
+
+/// Accounts `n` bytes written to a sink of the given kind (`string`, `ostream`, ...) in the statistics and the profile
+#if defined(FORMATPP_PROFILE) && defined(FORMATPP_STATS)
+#define FORMATPP_SINK_WRITE(sink, n) \
+    FORMATPP_RUNTIME_ONLY(::formatpp::profile::detail::add_bytes_and_stats(::formatpp::stats::counter::bytes_##sink, (n)))
+namespace profile {
+namespace detail {
+inline void add_bytes_and_stats(stats::counter c, uint64_t n)
+{
+    stats::detail::add(c, n);
+    add_bytes(n);
+}
+} // detail
+} // profile
+#elif defined(FORMATPP_PROFILE)
+#define FORMATPP_SINK_WRITE(sink, n) FORMATPP_RUNTIME_ONLY(::formatpp::profile::detail::add_bytes(n))
+#else
+#define FORMATPP_SINK_WRITE(sink, n) FORMATPP_STAT_ADD(bytes_##sink, n)
+#endif
+
+} // formatpp
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef FORMATPP_SCRATCH_H_
+#define FORMATPP_SCRATCH_H_
+
+#include <cstddef>
+#include <limits>
+
+namespace formatpp {
+
+namespace detail {
+
+// Compile-time bound of the temporary (scratch) buffer space that the built-in formatters may
+// need for a format string. Written as C++11 constexpr functions, hence the recursion.
+//
+// Per specifier, with N the largest number in it (covering the width and the precision):
+// - integers (and the integral part of floats) use up to max(67, N + 2) characters,
+// - `e` floats add a copy of the mantissa of N + 11 characters,
+// - positional (`f`) floats may need every digit of the largest `long double` in the specifier's radix.
+// Chrono specifiers (containing `%`) only render seconds and fractions through the integer formatter.
+
+constexpr size_t max_size(size_t a, size_t b)
+{
+    return a < b ? b : a;
+}
+
+/// Digits of the integral part of the largest `long double` in the given radix
+constexpr size_t max_integral_digits(int radix)
+{
+    return radix == 2 ? std::numeric_limits<long double>::max_exponent
+         : radix == 16 ? std::numeric_limits<long double>::max_exponent / 4 + 1
+         : std::numeric_limits<long double>::max_exponent10 + 1;
+}
+
+constexpr bool spec_end(char c)
+{
+    return c == '}' || c == '\0';
+}
+
+constexpr bool spec_contains(const char *s, char c)
+{
+    return spec_end(*s) ? false : *s == c || spec_contains(s + 1, c);
+}
+
+/// The largest decimal number in the specifier; `current` is the number being read
+constexpr size_t spec_max_number(const char *s, size_t current, size_t largest)
+{
+    return spec_end(*s) ? max_size(current, largest)
+         : (*s >= '0' && *s <= '9') ? spec_max_number(s + 1, current * 10 + (*s - '0'), largest)
+         : spec_max_number(s + 1, 0, max_size(current, largest));
+}
+
+constexpr int spec_float_radix(const char *s)
+{
+    return spec_contains(s, 'b') || spec_contains(s, 'B') ? 2
+         : spec_contains(s, 'a') || spec_contains(s, 'A') ? 16
+         : 10;
+}
+
+constexpr size_t integer_scratch(size_t n)
+{
+    return max_size(sizeof(long long) * 8 + 3, n + 2);
+}
+
+constexpr size_t spec_scratch_impl(const char *s, size_t n)
+{
+    return integer_scratch(n) + n + 11
+         + (spec_contains(s, 'f') || spec_contains(s, 'F') ? max_integral_digits(spec_float_radix(s)) + n + 3 : 0);
+}
+
+/// `s` points past the colon of a `{:spec}` placeholder
+constexpr size_t spec_scratch(const char *s)
+{
+    return spec_contains(s, '%') ? integer_scratch(9) : spec_scratch_impl(s, spec_max_number(s, 0, 0));
+}
+
+constexpr const char *skip_spec(const char *s)
+{
+    return spec_end(*s) ? s : skip_spec(s + 1);
+}
+
+constexpr const char *skip_index(const char *s)
+{
+    return (*s >= '0' && *s <= '9') ? skip_index(s + 1) : s;
+}
+
+constexpr size_t format_scratch(const char *s, size_t largest);
+
+constexpr size_t placeholder_scratch(const char *s, size_t largest)
+{
+    return *s == ':'
+         ? format_scratch(skip_spec(s + 1), max_size(largest, spec_scratch(s + 1)))
+         : format_scratch(s, max_size(largest, integer_scratch(0) + 11));
+}
+
+constexpr size_t format_scratch(const char *s, size_t largest)
+{
+    return *s == '\0' ? largest
+         : (*s == '{' && s[1] == '{') ? format_scratch(s + 2, largest)
+         : *s == '{' ? placeholder_scratch(skip_index(s + 1), largest)
+         : format_scratch(s + 1, largest);
+}
+
+} // detail
+
+/// @brief Upper bound of the scratch space needed to format with `format_string` using the built-in formatters
+constexpr size_t scratch_bound(const char *format_string)
+{
+    return detail::format_scratch(format_string, 0);
+}
+
+} // formatpp
+
+#endif
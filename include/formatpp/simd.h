@@ -0,0 +1,588 @@
+#ifndef FORMATPP_SIMD_H_
+#define FORMATPP_SIMD_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+// With GCC and Clang on x86, kernels for newer instruction sets are compiled with target attributes
+// and selected at run time, so the binary itself doesn't need -mssse3 or -mavx2.
+// Define FORMATPP_NO_SIMD_DISPATCH to use only what the compiler flags enable.
+#if !defined(FORMATPP_NO_SIMD_DISPATCH) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define FORMATPP_SIMD_DISPATCH 1
+#define FORMATPP_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FORMATPP_TARGET(isa)
+#endif
+
+#if defined(FORMATPP_SIMD_DISPATCH) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FORMATPP_SIMD_SSE2 1
+#endif
+
+#if defined(FORMATPP_SIMD_DISPATCH) || defined(__SSSE3__) || defined(__AVX2__)
+#include <tmmintrin.h>
+#define FORMATPP_SIMD_SSSE3 1
+#endif
+
+#if defined(FORMATPP_SIMD_DISPATCH) || defined(__AVX2__)
+#include <immintrin.h>
+#define FORMATPP_SIMD_AVX2 1
+#endif
+
+namespace formatpp {
+namespace simd {
+
+/// @brief Instruction set levels, in increasing order
+enum class level : int
+{
+    scalar,
+    sse2,
+    ssse3,
+    sse42,
+    avx2,
+    avx512
+};
+
+inline const char *level_name(level l) noexcept
+{
+    switch (l)
+    {
+    case level::sse2:
+        return "sse2";
+    case level::ssse3:
+        return "ssse3";
+    case level::sse42:
+        return "sse4.2";
+    case level::avx2:
+        return "avx2";
+    case level::avx512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+/// @brief Index of the lowest set bit; `mask` must be non-zero
+inline unsigned lowest_bit(unsigned mask) noexcept
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    unsigned n = 0;
+    while (!(mask & 1))
+    {
+        mask >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+namespace scalar {
+
+inline const char *find_any_of(const char *begin, const char *end, char a, char b, char c, char d)
+{
+    for (const char *p = begin; p < end; p++)
+    {
+        char x = *p;
+        if (x == a || x == b || x == c || x == d)
+            return p;
+    }
+    return end;
+}
+
+inline const char *find_control_or_any_of(const char *begin, const char *end, char a, char b, char c)
+{
+    for (const char *p = begin; p < end; p++)
+    {
+        char x = *p;
+        if (static_cast<unsigned char>(x) < 0x20 || x == a || x == b || x == c)
+            return p;
+    }
+    return end;
+}
+
+inline const char *find_non_ascii(const char *begin, const char *end)
+{
+    for (const char *p = begin; p < end; p++)
+    {
+        if (static_cast<unsigned char>(*p) >= 0x80)
+            return p;
+    }
+    return end;
+}
+
+/// Vectorized widening only; the caller converts the remainder
+inline size_t widen_ascii(void *, const char *, size_t)
+{
+    return 0;
+}
+
+inline void hex_encode(char *dst, const uint8_t *src, size_t n, const char *digits)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        dst[2*i] = digits[src[i] >> 4];
+        dst[2*i + 1] = digits[src[i] & 15];
+    }
+}
+
+} // scalar
+
+#ifdef FORMATPP_SIMD_SSE2
+namespace sse2 {
+
+FORMATPP_TARGET("sse2")
+inline const char *find_any_of(const char *begin, const char *end, char a, char b, char c, char d)
+{
+    const char *p = begin;
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c);
+    const __m128i vd = _mm_set1_epi8(d);
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(x, vc), _mm_cmpeq_epi8(x, vd)));
+        if (unsigned mask = _mm_movemask_epi8(eq))
+            return p + lowest_bit(mask);
+    }
+    return scalar::find_any_of(p, end, a, b, c, d);
+}
+
+FORMATPP_TARGET("sse2")
+inline const char *find_control_or_any_of(const char *begin, const char *end, char a, char b, char c)
+{
+    const char *p = begin;
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c);
+    const __m128i max_control = _mm_set1_epi8(0x1f);
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(x, max_control), x);
+        __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(x, vc), control));
+        if (unsigned mask = _mm_movemask_epi8(eq))
+            return p + lowest_bit(mask);
+    }
+    return scalar::find_control_or_any_of(p, end, a, b, c);
+}
+
+FORMATPP_TARGET("sse2")
+inline const char *find_non_ascii(const char *begin, const char *end)
+{
+    const char *p = begin;
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        if (unsigned mask = _mm_movemask_epi8(x))
+            return p + lowest_bit(mask);
+    }
+    return scalar::find_non_ascii(p, end);
+}
+
+FORMATPP_TARGET("sse2")
+inline size_t widen_ascii16(void *dst, const char *src, size_t n)
+{
+    char *d = static_cast<char *>(dst);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        if (_mm_movemask_epi8(x))
+            break;
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 2*i), _mm_unpacklo_epi8(x, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 2*i + 16), _mm_unpackhi_epi8(x, zero));
+    }
+    return i;
+}
+
+FORMATPP_TARGET("sse2")
+inline size_t widen_ascii32(void *dst, const char *src, size_t n)
+{
+    char *d = static_cast<char *>(dst);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        if (_mm_movemask_epi8(x))
+            break;
+        __m128i lo = _mm_unpacklo_epi8(x, zero);
+        __m128i hi = _mm_unpackhi_epi8(x, zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 4*i), _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 4*i + 16), _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 4*i + 32), _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 4*i + 48), _mm_unpackhi_epi16(hi, zero));
+    }
+    return i;
+}
+
+FORMATPP_TARGET("sse2")
+inline __m128i nibbles_to_digits(__m128i x, __m128i nine, __m128i zero, __m128i letter_offset)
+{
+    return _mm_add_epi8(_mm_add_epi8(x, zero), _mm_and_si128(_mm_cmpgt_epi8(x, nine), letter_offset));
+}
+
+FORMATPP_TARGET("sse2")
+inline void hex_encode(char *dst, const uint8_t *src, size_t n, const char *digits)
+{
+    size_t i = 0;
+    // Without a byte shuffle, compute the digits; this requires '0'-'9' followed by contiguous letters
+    bool contiguous = digits[0] == '0' && digits[9] == '9' && digits[15] == digits[10] + 5;
+    if (contiguous)
+    {
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        const __m128i nine = _mm_set1_epi8(9);
+        const __m128i zero = _mm_set1_epi8('0');
+        const __m128i letter_offset = _mm_set1_epi8(static_cast<char>(digits[10] - '0' - 10));
+        for (; i + 16 <= n; i += 16)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            __m128i lo = nibbles_to_digits(_mm_and_si128(x, nibble), nine, zero, letter_offset);
+            __m128i hi = nibbles_to_digits(_mm_and_si128(_mm_srli_epi16(x, 4), nibble), nine, zero, letter_offset);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2*i), _mm_unpacklo_epi8(hi, lo));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2*i + 16), _mm_unpackhi_epi8(hi, lo));
+        }
+    }
+    scalar::hex_encode(dst + 2*i, src + i, n - i, digits);
+}
+
+} // sse2
+#endif
+
+#ifdef FORMATPP_SIMD_SSSE3
+namespace ssse3 {
+
+FORMATPP_TARGET("ssse3")
+inline void hex_encode(char *dst, const uint8_t *src, size_t n, const char *digits)
+{
+    size_t i = 0;
+    const __m128i table = _mm_loadu_si128(reinterpret_cast<const __m128i *>(digits));
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(x, nibble));
+        __m128i hi = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(x, 4), nibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2*i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2*i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    scalar::hex_encode(dst + 2*i, src + i, n - i, digits);
+}
+
+} // ssse3
+#endif
+
+#ifdef FORMATPP_SIMD_AVX2
+namespace avx2 {
+
+FORMATPP_TARGET("avx2")
+inline const char *find_any_of(const char *begin, const char *end, char a, char b, char c, char d)
+{
+    const char *p = begin;
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    const __m256i vc = _mm256_set1_epi8(c);
+    const __m256i vd = _mm256_set1_epi8(d);
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i eq = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, va), _mm256_cmpeq_epi8(x, vb)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(x, vc), _mm256_cmpeq_epi8(x, vd)));
+        if (unsigned mask = _mm256_movemask_epi8(eq))
+            return p + lowest_bit(mask);
+    }
+    return sse2::find_any_of(p, end, a, b, c, d);
+}
+
+FORMATPP_TARGET("avx2")
+inline const char *find_control_or_any_of(const char *begin, const char *end, char a, char b, char c)
+{
+    const char *p = begin;
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    const __m256i vc = _mm256_set1_epi8(c);
+    const __m256i max_control = _mm256_set1_epi8(0x1f);
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(x, max_control), x);
+        __m256i eq = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, va), _mm256_cmpeq_epi8(x, vb)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(x, vc), control));
+        if (unsigned mask = _mm256_movemask_epi8(eq))
+            return p + lowest_bit(mask);
+    }
+    return sse2::find_control_or_any_of(p, end, a, b, c);
+}
+
+FORMATPP_TARGET("avx2")
+inline const char *find_non_ascii(const char *begin, const char *end)
+{
+    const char *p = begin;
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        if (unsigned mask = _mm256_movemask_epi8(x))
+            return p + lowest_bit(mask);
+    }
+    return sse2::find_non_ascii(p, end);
+}
+
+FORMATPP_TARGET("avx2")
+inline size_t widen_ascii16(void *dst, const char *src, size_t n)
+{
+    char *d = static_cast<char *>(dst);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        if (_mm256_movemask_epi8(x))
+            break;
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + 2*i), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(x)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + 2*i + 32), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(x, 1)));
+    }
+    return i + sse2::widen_ascii16(d + 2*i, src + i, n - i);
+}
+
+FORMATPP_TARGET("avx2")
+inline size_t widen_ascii32(void *dst, const char *src, size_t n)
+{
+    char *d = static_cast<char *>(dst);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        if (_mm256_movemask_epi8(x))
+            break;
+        for (int k = 0; k < 4; k++)
+        {
+            __m128i part = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i + 8*k));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(d + 4*i + 32*k), _mm256_cvtepu8_epi32(part));
+        }
+    }
+    return i + sse2::widen_ascii32(d + 4*i, src + i, n - i);
+}
+
+FORMATPP_TARGET("avx2")
+inline void hex_encode(char *dst, const uint8_t *src, size_t n, const char *digits)
+{
+    size_t i = 0;
+    const __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(digits)));
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(x, nibble));
+        __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble));
+        // unpack works within 128-bit lanes; put the lanes back in order
+        __m256i first = _mm256_unpacklo_epi8(hi, lo);
+        __m256i second = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 2*i), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 2*i + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    ssse3::hex_encode(dst + 2*i, src + i, n - i, digits);
+}
+
+} // avx2
+#endif
+
+/// @brief The kernels bound for one instruction set level
+struct kernel_table
+{
+    level isa;
+    const char *(*find_any_of)(const char *, const char *, char, char, char, char);
+    const char *(*find_control_or_any_of)(const char *, const char *, char, char, char);
+    const char *(*find_non_ascii)(const char *, const char *);
+    size_t (*widen_ascii16)(void *, const char *, size_t);
+    size_t (*widen_ascii32)(void *, const char *, size_t);
+    void (*hex_encode)(char *, const uint8_t *, size_t, const char *);
+};
+
+/// @brief The best kernel table not exceeding `l`
+///
+/// There are no separate SSE4.2 and AVX-512 kernels; these levels use the SSSE3 and AVX2 ones.
+inline const kernel_table &kernels_for(level l) noexcept
+{
+    static const kernel_table tables[] = {
+        { level::scalar, scalar::find_any_of, scalar::find_control_or_any_of, scalar::find_non_ascii,
+          scalar::widen_ascii, scalar::widen_ascii, scalar::hex_encode },
+#ifdef FORMATPP_SIMD_SSE2
+        { level::sse2, sse2::find_any_of, sse2::find_control_or_any_of, sse2::find_non_ascii,
+          sse2::widen_ascii16, sse2::widen_ascii32, sse2::hex_encode },
+#endif
+#ifdef FORMATPP_SIMD_SSSE3
+        { level::ssse3, sse2::find_any_of, sse2::find_control_or_any_of, sse2::find_non_ascii,
+          sse2::widen_ascii16, sse2::widen_ascii32, ssse3::hex_encode },
+#endif
+#ifdef FORMATPP_SIMD_AVX2
+        { level::avx2, avx2::find_any_of, avx2::find_control_or_any_of, avx2::find_non_ascii,
+          avx2::widen_ascii16, avx2::widen_ascii32, avx2::hex_encode },
+#endif
+    };
+    const kernel_table *best = &tables[0];
+    for (const kernel_table &t : tables)
+    {
+        if (t.isa <= l)
+            best = &t;
+    }
+    return *best;
+}
+
+/// @brief The highest level supported by both the CPU and the build
+inline level detected_level() noexcept
+{
+#if defined(FORMATPP_SIMD_DISPATCH)
+    static const level detected = []
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512bw"))
+            return level::avx512;
+        if (__builtin_cpu_supports("avx2"))
+            return level::avx2;
+        if (__builtin_cpu_supports("sse4.2"))
+            return level::sse42;
+        if (__builtin_cpu_supports("ssse3"))
+            return level::ssse3;
+        if (__builtin_cpu_supports("sse2"))
+            return level::sse2;
+        return level::scalar;
+    }();
+    return detected;
+#elif defined(__AVX2__)
+    return level::avx2;
+#elif defined(FORMATPP_SIMD_SSSE3)
+    return level::ssse3;
+#elif defined(FORMATPP_SIMD_SSE2)
+    return level::sse2;
+#else
+    return level::scalar;
+#endif
+}
+
+namespace detail {
+
+/// @brief Parses a level name, as returned by level_name; returns false if it's not recognized
+inline bool parse_level(const char *name, level &l) noexcept
+{
+    for (int i = static_cast<int>(level::scalar); i <= static_cast<int>(level::avx512); i++)
+    {
+        if (!std::strcmp(name, level_name(static_cast<level>(i))))
+        {
+            l = static_cast<level>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+inline level initial_level() noexcept
+{
+    level l = detected_level();
+    level requested;
+    const char *env = std::getenv("FORMATPP_SIMD");
+    if (env && parse_level(env, requested) && requested < l)
+        l = requested;
+    return l;
+}
+
+inline std::atomic<const kernel_table *> &active_kernels() noexcept
+{
+    static std::atomic<const kernel_table *> table(&kernels_for(initial_level()));
+    return table;
+}
+
+} // detail
+
+/// @brief The kernels in use; selected on first use from the detected level, which can be lowered
+/// with the `FORMATPP_SIMD` environment variable (`scalar`, `sse2`, `ssse3`, `sse4.2`, `avx2`, `avx512`)
+inline const kernel_table &kernels() noexcept
+{
+    return *detail::active_kernels().load(std::memory_order_relaxed);
+}
+
+inline level active_level() noexcept
+{
+    return kernels().isa;
+}
+
+/// @brief Forces the kernels of a lower instruction set level, e.g. for testing and benchmarking
+///
+/// Levels above the detected one are clamped. Safe to call while other threads are formatting.
+/// @return The level of the kernels now in use
+inline level set_level(level l) noexcept
+{
+    if (l > detected_level())
+        l = detected_level();
+    const kernel_table &table = kernels_for(l);
+    detail::active_kernels().store(&table, std::memory_order_relaxed);
+    return table.isa;
+}
+
+/// @brief Finds the first character in [begin, end) equal to any of `a`, `b`, `c`, `d`.
+/// @return Pointer to the character found or `end`
+inline const char *find_any_of(const char *begin, const char *end, char a, char b, char c, char d) noexcept
+{
+    return kernels().find_any_of(begin, end, a, b, c, d);
+}
+
+/// @brief Finds the first occurrence of `c` in [begin, end).
+/// @return Pointer to the character found or `end`
+inline const char *find_char(const char *begin, const char *end, char c) noexcept
+{
+    return find_any_of(begin, end, c, c, c, c);
+}
+
+/// @brief Finds the first control character (< 0x20) or a character equal to any of `a`, `b`, `c`.
+/// @return Pointer to the character found or `end`
+inline const char *find_control_or_any_of(const char *begin, const char *end, char a, char b, char c) noexcept
+{
+    return kernels().find_control_or_any_of(begin, end, a, b, c);
+}
+
+/// @brief Finds the first byte outside of the ASCII range (>= 0x80).
+/// @return Pointer to the byte found or `end`
+inline const char *find_non_ascii(const char *begin, const char *end) noexcept
+{
+    return kernels().find_non_ascii(begin, end);
+}
+
+/// @brief Zero-extends the leading ASCII characters of `src` into 16- or 32-bit code units
+/// @return Number of characters converted; conversion stops at the first non-ASCII byte
+template <typename Char>
+inline size_t widen_ascii(Char *dst, const char *src, size_t n) noexcept
+{
+    static_assert(sizeof(Char) == 2 || sizeof(Char) == 4, "Only 16- and 32-bit code units are supported");
+    const kernel_table &k = kernels();
+    size_t i = sizeof(Char) == 2 ? k.widen_ascii16(dst, src, n) : k.widen_ascii32(dst, src, n);
+    for (; i < n; i++)
+    {
+        unsigned char c = src[i];
+        if (c >= 0x80)
+            break;
+        dst[i] = c;
+    }
+    return i;
+}
+
+/// @brief Writes two hex digits per byte of `src` (high nibble first) to `dst`
+///
+/// @param digits  digit table with at least 16 entries, e.g. `integer_format_options::lowercase_digits()`
+inline void hex_encode(char *dst, const uint8_t *src, size_t n, const char *digits) noexcept
+{
+    kernels().hex_encode(dst, src, n, digits);
+}
+
+} // simd
+} // formatpp
+
+#endif
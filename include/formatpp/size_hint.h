@@ -0,0 +1,109 @@
+#ifndef FORMATPP_SIZE_HINT_H_
+#define FORMATPP_SIZE_HINT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace formatpp {
+
+/// @brief Per-call-site prediction of the output length of `format_to(std::string &, ...)` and `format_str`
+///
+/// When the library is compiled with `FORMATPP_SIZE_HINTS` defined, each thread remembers, for each
+/// format string (by address), an exponentially weighted maximum of its output lengths. The next call
+/// with that format string reserves that many characters up front, so a call site producing similar
+/// lengths every time allocates once instead of growing the string step by step.
+namespace size_hint {
+
+#ifdef FORMATPP_SIZE_HINTS
+
+constexpr bool enabled = true;
+
+namespace detail {
+
+enum : size_t
+{
+    table_size = 256,
+    /// A shorter output lowers the estimate by 1/2^decay_shift of the difference
+    decay_shift = 3
+};
+
+struct slot
+{
+    const char *key;
+    size_t estimate;
+};
+
+/// Direct-mapped and zero-initialized, so that it needs no constructor call on first use
+inline slot &lookup(const char *key)
+{
+    static thread_local slot table[table_size];
+    size_t h = static_cast<size_t>((reinterpret_cast<uintptr_t>(key) >> 3) * 0x9E3779B97F4A7C15ull);
+    return table[h >> (sizeof(size_t) * 8 - 8)];  // the top 8 bits index the 256 slots
+}
+
+/// Colliding format strings evict each other
+inline slot &find(const char *key)
+{
+    slot &s = lookup(key);
+    if (s.key != key)
+    {
+        s.key = key;
+        s.estimate = 0;
+    }
+    return s;
+}
+
+/// @brief Reserves the predicted length at construction; `update` records the actual one
+class prediction
+{
+public:
+    prediction(std::string &out, const char *format) : s(find(format)), start(out.size())
+    {
+        size_t needed = start + s.estimate;
+        if (needed > out.capacity())
+        {
+            // Appending to a non-empty string keeps the growth geometric
+            out.reserve(start && needed < 2 * out.capacity() ? 2 * out.capacity() : needed);
+        }
+    }
+
+    void update(const std::string &out)
+    {
+        size_t len = out.size() - start;
+        if (len >= s.estimate)
+            s.estimate = len;
+        else
+            s.estimate -= (s.estimate - len) >> decay_shift;
+    }
+
+private:
+    slot &s;
+    size_t start;
+};
+
+} // detail
+
+/// @brief The length the calling thread will reserve for the next call with `format`; 0 if unknown
+inline size_t estimate(const char *format)
+{
+    const detail::slot &s = detail::lookup(format);
+    return s.key == format ? s.estimate : 0;
+}
+
+#else
+
+constexpr bool enabled = false;
+
+inline size_t estimate(const char *)
+{
+    return 0;
+}
+
+#endif
+
+} // size_hint
+
+} // formatpp
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef FORMATPP_STATS_H_
+#define FORMATPP_STATS_H_
+
+#include "constexpr.h"
+#include <cstddef>
+#include <cstdint>
+
+#ifdef FORMATPP_STATS
+#include <atomic>
+#include <mutex>
+#endif
+
+namespace formatpp {
+
+namespace stats {
+
+/// @brief Events counted when the library is compiled with `FORMATPP_STATS` defined
+enum class counter : unsigned
+{
+    /// A temporary buffer didn't fit in the 256-byte static buffer of the output context
+    tmp_buffer_spills,
+    /// A floating point value needed more digits than fit in 64 bits (the slow `long double` path)
+    long_double_positional,
+    /// A value without a formatter was printed with `operator<<` through an `std::ostringstream`
+    ios_fallback,
+    bytes_string,
+    bytes_ostream,
+    bytes_char_buf,
+    bytes_buffered_sink,
+    bytes_counting_sink,
+    /// UTF-8 bytes passed to a `wide_sink`, before transcoding
+    bytes_wide_sink,
+    num_counters
+};
+
+enum : size_t { num_counters = static_cast<size_t>(counter::num_counters) };
+
+inline const char *name(counter c) noexcept
+{
+    static const char *const names[num_counters] = {
+        "tmp_buffer_spills",
+        "long_double_positional",
+        "ios_fallback",
+        "bytes_string",
+        "bytes_ostream",
+        "bytes_char_buf",
+        "bytes_buffered_sink",
+        "bytes_counting_sink",
+        "bytes_wide_sink",
+    };
+    return static_cast<size_t>(c) < num_counters ? names[static_cast<size_t>(c)] : "";
+}
+
+/// @brief Counter values summed over all threads, including the ones that have exited
+struct snapshot
+{
+    uint64_t values[num_counters] = {};
+
+    uint64_t operator[](counter c) const noexcept { return values[static_cast<size_t>(c)]; }
+
+    /// @brief Calls `f(name, value)` for each counter, e.g. to export them to a metrics system
+    template <typename F>
+    void for_each(F &&f) const
+    {
+        for (size_t i = 0; i < num_counters; i++)
+            f(name(static_cast<counter>(i)), values[i]);
+    }
+};
+
+#ifdef FORMATPP_STATS
+
+constexpr bool enabled = true;
+
+namespace detail {
+
+/// Counters of one thread; only the owner writes them, so the increments don't need atomic read-modify-write
+struct thread_counters
+{
+    std::atomic<uint64_t> values[num_counters];
+    thread_counters *prev = nullptr, *next = nullptr;
+
+    thread_counters();
+    ~thread_counters();
+};
+
+struct registry
+{
+    std::mutex lock;
+    thread_counters *threads = nullptr;
+    /// Totals of the threads that have exited
+    uint64_t retired[num_counters] = {};
+
+    static registry &instance()
+    {
+        static registry r;
+        return r;
+    }
+};
+
+inline thread_counters::thread_counters()
+{
+    for (auto &v : values)
+        v.store(0, std::memory_order_relaxed);
+    registry &r = registry::instance();
+    std::lock_guard<std::mutex> guard(r.lock);
+    next = r.threads;
+    if (next)
+        next->prev = this;
+    r.threads = this;
+}
+
+inline thread_counters::~thread_counters()
+{
+    registry &r = registry::instance();
+    std::lock_guard<std::mutex> guard(r.lock);
+    for (size_t i = 0; i < num_counters; i++)
+        r.retired[i] += values[i].load(std::memory_order_relaxed);
+    if (prev)
+        prev->next = next;
+    else
+        r.threads = next;
+    if (next)
+        next->prev = prev;
+}
+
+inline thread_counters &this_thread()
+{
+    static thread_local thread_counters counters;
+    return counters;
+}
+
+inline void add(counter c, uint64_t n)
+{
+    std::atomic<uint64_t> &v = this_thread().values[static_cast<size_t>(c)];
+    v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+} // detail
+
+/// @brief Sums the counters of all threads
+inline snapshot collect()
+{
+    snapshot s;
+    detail::registry &r = detail::registry::instance();
+    std::lock_guard<std::mutex> guard(r.lock);
+    for (size_t i = 0; i < num_counters; i++)
+        s.values[i] = r.retired[i];
+    for (detail::thread_counters *t = r.threads; t; t = t->next)
+        for (size_t i = 0; i < num_counters; i++)
+            s.values[i] += t->values[i].load(std::memory_order_relaxed);
+    return s;
+}
+
+/// @brief Zeroes the counters of all threads
+///
+/// Increments made concurrently by other threads may be lost.
+inline void reset()
+{
+    detail::registry &r = detail::registry::instance();
+    std::lock_guard<std::mutex> guard(r.lock);
+    for (auto &v : r.retired)
+        v = 0;
+    for (detail::thread_counters *t = r.threads; t; t = t->next)
+        for (auto &v : t->values)
+            v.store(0, std::memory_order_relaxed);
+}
+
+#define FORMATPP_STAT_ADD(c, n) FORMATPP_RUNTIME_ONLY(::formatpp::stats::detail::add(::formatpp::stats::counter::c, (n)))
+
+#else
+
+constexpr bool enabled = false;
+
+inline snapshot collect() { return {}; }
+inline void reset() {}
+
+#define FORMATPP_STAT_ADD(c, n) ((void)0)
+
+#endif
+
+#define FORMATPP_STAT_INC(c) FORMATPP_STAT_ADD(c, 1)
+
+} // stats
+
+} // formatpp
+
+#endif
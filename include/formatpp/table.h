@@ -0,0 +1,373 @@
+#ifndef FORMATPP_TABLE_H_
+#define FORMATPP_TABLE_H_
+
+#include "format.h"
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace formatpp {
+
+struct table_style
+{
+    const char *column_separator = " ";
+    const char *row_end = "\n";
+    /// Character used for the rule under the header row; 0 disables the rule
+    char header_rule = '-';
+};
+
+/// @brief A non-owning, row-major view of a matrix
+template <typename T>
+struct matrix_view
+{
+    matrix_view() = default;
+    matrix_view(const T *data, size_t rows, size_t cols, size_t row_stride = 0)
+    : data(data), rows(rows), cols(cols), row_stride(row_stride ? row_stride : cols)
+    {
+    }
+
+    const T &operator()(size_t r, size_t c) const { return data[r * row_stride + c]; }
+
+    const T *data = nullptr;
+    size_t rows = 0;
+    size_t cols = 0;
+    /// Distance between rows, in elements
+    size_t row_stride = 0;
+};
+
+template <typename T>
+matrix_view<T> make_matrix_view(const T *data, size_t rows, size_t cols, size_t row_stride = 0)
+{
+    return { data, rows, cols, row_stride };
+}
+
+namespace detail {
+
+using measure_context = output_context<counting_sink &>;
+
+template <typename T>
+uint32_t measure(measure_context &ctx, const T &value, const format_options<T> &options)
+{
+    ctx.out().count = 0;
+    formatter<T>::format(ctx, value, options);
+    return static_cast<uint32_t>(ctx.out().count);
+}
+
+template <typename Options>
+padding cell_padding(const Options &options, uint32_t column_width, uint32_t cell_width, std::true_type)
+{
+    return compute_padding(options, column_width, cell_width);
+}
+
+template <typename Options>
+padding cell_padding(const Options &, uint32_t column_width, uint32_t cell_width, std::false_type)
+{
+    return { column_width - cell_width, 0 };
+}
+
+/// @brief Padding of a cell within its column, using the column's alignment (right by default)
+template <typename Options>
+padding cell_padding(const Options &options, uint32_t column_width, uint32_t cell_width)
+{
+    return cell_padding(options, column_width, cell_width, std::is_base_of<align_options, Options>());
+}
+
+template <typename Options>
+const align_options &column_alignment(const Options &options, std::true_type)
+{
+    return options;
+}
+
+template <typename Options>
+const align_options &column_alignment(const Options &, std::false_type)
+{
+    static const align_options right;
+    return right;
+}
+
+/// @brief Fill character and alignment of a column; types without them are padded with spaces on the left
+template <typename Options>
+const align_options &column_alignment(const Options &options)
+{
+    return column_alignment(options, std::is_base_of<align_options, Options>());
+}
+
+template <typename Context>
+void put_header_rule(Context &ctx, const std::vector<uint32_t> &column_widths, const table_style &style)
+{
+    for (size_t c = 0; c < column_widths.size(); c++)
+    {
+        if (c)
+            put(ctx.out(), style.column_separator);
+        put(ctx.out(), column_widths[c], style.header_rule);
+    }
+    put(ctx.out(), style.row_end);
+}
+
+} // detail
+
+/// @brief Prints a matrix with columns aligned to the widest cell
+///
+/// The matrix is formatted twice: first into a counting context, to measure each cell,
+/// then into the actual output, padded to the column width. The width buffers are kept
+/// between calls, so formatting multiple matrices with one object does not allocate.
+template <typename T>
+class matrix_formatter
+{
+public:
+    explicit matrix_formatter(const char *spec = "", const table_style &style = {})
+    : style(style)
+    {
+        options.emplace_back(spec);
+    }
+
+    /// @param column_specs  format specifiers for each column of the matrix
+    matrix_formatter(std::initializer_list<const char *> column_specs, const table_style &style = {})
+    : style(style)
+    {
+        for (const char *spec : column_specs)
+            options.emplace_back(spec);
+    }
+
+    explicit matrix_formatter(const format_options<T> &element_options, const table_style &style = {})
+    : options(1, element_options), style(style)
+    {
+    }
+
+    template <typename Output>
+    void format(output_context<Output> &ctx, const matrix_view<T> &m)
+    {
+        if (options.size() != 1 && options.size() != m.cols)
+            FORMATPP_FAIL(invalid_argument, std::logic_error("Number of column format specifiers doesn't match the number of columns"));
+
+        column_widths.assign(m.cols, 0);
+        cell_widths.resize(m.rows * m.cols);
+
+        counting_sink counter;
+        detail::measure_context mctx(counter);
+        uint32_t *w = cell_widths.data();
+        for (size_t r = 0; r < m.rows; r++)
+        {
+            for (size_t c = 0; c < m.cols; c++)
+            {
+                *w = detail::measure(mctx, m(r, c), column_options(c));
+                if (*w > column_widths[c])
+                    column_widths[c] = *w;
+                w++;
+            }
+        }
+
+        w = cell_widths.data();
+        for (size_t r = 0; r < m.rows; r++)
+        {
+            for (size_t c = 0; c < m.cols; c++)
+            {
+                if (c)
+                    put(ctx.out(), style.column_separator);
+                const auto &opt = column_options(c);
+                auto pad = detail::cell_padding(opt, column_widths[c], *w);
+                char fill = detail::column_alignment(opt).fill;
+                put_fill(ctx.out(), pad.before, fill);
+                formatter<T>::format(ctx, m(r, c), opt);
+                put_fill(ctx.out(), pad.after, fill);
+                w++;
+            }
+            put(ctx.out(), style.row_end);
+        }
+    }
+
+    template <typename Output>
+    void format(Output &out, const matrix_view<T> &m)
+    {
+        output_context<Output &> ctx(out);
+        format(ctx, m);
+    }
+
+private:
+    const format_options<T> &column_options(size_t c) const
+    {
+        return options.size() == 1 ? options[0] : options[c];
+    }
+
+    std::vector<format_options<T>> options;
+    table_style style;
+    std::vector<uint32_t> column_widths, cell_widths;
+};
+
+/// @brief Prints rows of heterogeneous columns (tuples), with a header row
+///
+/// Usage:
+/// ```
+/// std::vector<std::tuple<std::string, int, double>> rows = ...;
+/// table_formatter<std::string, int, double> table({ "name", "count", "mean" }, { "", "", ".2f" });
+/// table.format(std::cout, rows);
+/// ```
+template <typename... Columns>
+class table_formatter
+{
+public:
+    static constexpr size_t num_columns = sizeof...(Columns);
+
+    explicit table_formatter(std::initializer_list<const char *> headers = {},
+                             std::initializer_list<const char *> column_specs = {},
+                             const table_style &style = {})
+    : headers(headers), style(style)
+    {
+        if (headers.size() != 0 && headers.size() != num_columns)
+        {
+            // Without exceptions, the object is still used: leave it without headers
+            this->headers.clear();
+            FORMATPP_FAIL(invalid_argument, std::logic_error("Number of column headers doesn't match the number of columns"));
+        }
+        if (column_specs.size() != 0)
+        {
+            if (column_specs.size() != num_columns)
+                FORMATPP_FAIL(invalid_argument, std::logic_error("Number of column format specifiers doesn't match the number of columns"));
+            parse_specs(column_specs.begin(), std::integral_constant<size_t, 0>());
+        }
+    }
+
+    template <typename Output, typename Rows>
+    void format(output_context<Output> &ctx, const Rows &rows)
+    {
+        column_widths.assign(num_columns, 0);
+        cell_widths.clear();
+
+        counting_sink counter;
+        detail::measure_context mctx(counter);
+        format_options<const char *> header_options;
+        for (size_t c = 0; c < headers.size(); c++)
+            column_widths[c] = detail::measure(mctx, headers[c], header_options);
+        for (const auto &row : rows)
+            measure_row(mctx, row, std::integral_constant<size_t, 0>());
+
+        if (!headers.empty())
+        {
+            print_header(ctx, header_options, std::integral_constant<size_t, 0>());
+            put(ctx.out(), style.row_end);
+            if (style.header_rule)
+                detail::put_header_rule(ctx, column_widths, style);
+        }
+
+        const uint32_t *w = cell_widths.data();
+        for (const auto &row : rows)
+        {
+            print_row(ctx, row, w, std::integral_constant<size_t, 0>());
+            put(ctx.out(), style.row_end);
+        }
+    }
+
+    template <typename Output, typename Rows>
+    void format(Output &out, const Rows &rows)
+    {
+        output_context<Output &> ctx(out);
+        format(ctx, rows);
+    }
+
+private:
+    using column_types = std::tuple<Columns...>;
+
+    template <size_t index>
+    using column_type = typename std::tuple_element<index, column_types>::type;
+
+    void parse_specs(const char *const *, std::integral_constant<size_t, num_columns>)
+    {
+    }
+
+    template <size_t index>
+    void parse_specs(const char *const *specs, std::integral_constant<size_t, index>)
+    {
+        std::get<index>(options) = format_options<column_type<index>>(specs[index]);
+        parse_specs(specs, std::integral_constant<size_t, index + 1>());
+    }
+
+    template <typename Row>
+    void measure_row(detail::measure_context &, const Row &, std::integral_constant<size_t, num_columns>)
+    {
+    }
+
+    template <typename Row, size_t index>
+    void measure_row(detail::measure_context &mctx, const Row &row, std::integral_constant<size_t, index>)
+    {
+        uint32_t w = detail::measure<column_type<index>>(mctx, std::get<index>(row), std::get<index>(options));
+        cell_widths.push_back(w);
+        if (w > column_widths[index])
+            column_widths[index] = w;
+        measure_row(mctx, row, std::integral_constant<size_t, index + 1>());
+    }
+
+    template <typename Context>
+    void print_header(Context &, format_options<const char *> &, std::integral_constant<size_t, num_columns>)
+    {
+    }
+
+    /// Headers are aligned like their columns, but padded with spaces
+    template <typename Context, size_t index>
+    void print_header(Context &ctx, format_options<const char *> &header_options, std::integral_constant<size_t, index>)
+    {
+        if (index > 0)
+            put(ctx.out(), style.column_separator);
+        header_options.width = column_widths[index];
+        header_options.align = detail::column_alignment(std::get<index>(options)).align;
+        formatter<const char *>::format(ctx, headers[index], header_options);
+        print_header(ctx, header_options, std::integral_constant<size_t, index + 1>());
+    }
+
+    template <typename Context, typename Row>
+    void print_row(Context &, const Row &, const uint32_t *&, std::integral_constant<size_t, num_columns>)
+    {
+    }
+
+    template <typename Context, typename Row, size_t index>
+    void print_row(Context &ctx, const Row &row, const uint32_t *&w, std::integral_constant<size_t, index>)
+    {
+        if (index > 0)
+            put(ctx.out(), style.column_separator);
+        const auto &opt = std::get<index>(options);
+        auto pad = detail::cell_padding(opt, column_widths[index], *w);
+        char fill = detail::column_alignment(opt).fill;
+        put_fill(ctx.out(), pad.before, fill);
+        formatter<column_type<index>>::format(ctx, std::get<index>(row), opt);
+        put_fill(ctx.out(), pad.after, fill);
+        w++;
+        print_row(ctx, row, w, std::integral_constant<size_t, index + 1>());
+    }
+
+    std::vector<const char *> headers;
+    std::tuple<format_options<Columns>...> options;
+    table_style style;
+    std::vector<uint32_t> column_widths, cell_widths;
+};
+
+template <typename... Columns>
+constexpr size_t table_formatter<Columns...>::num_columns;
+
+template <typename T>
+struct matrix_format_options
+{
+    void parse(const char *options, size_t &i)
+    {
+        element.parse(options, i);
+    }
+
+    format_options<T> element;
+};
+
+template <typename T>
+struct default_format_options<matrix_view<T>, void> : matrix_format_options<T>
+{};
+
+/// @brief Formats a matrix_view with `{}`; the format specifier applies to every element
+template <typename T>
+struct formatter<matrix_view<T>>
+{
+    template <typename Context>
+    static void format(Context &ctx, const matrix_view<T> &m, const format_options<matrix_view<T>> &options)
+    {
+        matrix_formatter<T>(options.element).format(ctx, m);
+    }
+};
+
+} // formatpp
+
+#endif
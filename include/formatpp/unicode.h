@@ -0,0 +1,280 @@
+#ifndef FORMATPP_UNICODE_H_
+#define FORMATPP_UNICODE_H_
+
+#include "simd.h"
+#include <cstddef>
+
+namespace formatpp {
+
+/// @brief Unit in which string width and precision are measured
+enum class string_width : char
+{
+    bytes,
+    code_points,
+    /// Terminal columns - East Asian wide and fullwidth characters take two, combining marks none
+    columns
+};
+
+namespace unicode {
+
+/// @brief Decodes one UTF-8 sequence starting at `p`
+///
+/// Invalid, overlong and truncated sequences decode as a single byte, U+FFFD.
+/// @return Number of bytes consumed (1-4)
+inline size_t decode_utf8(const char *p, const char *end, char32_t &cp) noexcept
+{
+    unsigned lead = static_cast<unsigned char>(*p);
+    size_t n;
+    char32_t min;
+    if (lead < 0x80)
+    {
+        cp = lead;
+        return 1;
+    }
+    else if ((lead & 0xe0) == 0xc0)
+    {
+        n = 2;
+        cp = lead & 0x1f;
+        min = 0x80;
+    }
+    else if ((lead & 0xf0) == 0xe0)
+    {
+        n = 3;
+        cp = lead & 0x0f;
+        min = 0x800;
+    }
+    else if ((lead & 0xf8) == 0xf0)
+    {
+        n = 4;
+        cp = lead & 0x07;
+        min = 0x10000;
+    }
+    else
+    {
+        cp = 0xfffd;
+        return 1;
+    }
+
+    if (static_cast<size_t>(end - p) < n)
+    {
+        cp = 0xfffd;
+        return 1;
+    }
+    for (size_t i = 1; i < n; i++)
+    {
+        unsigned b = static_cast<unsigned char>(p[i]);
+        if ((b & 0xc0) != 0x80)
+        {
+            cp = 0xfffd;
+            return 1;
+        }
+        cp = cp << 6 | (b & 0x3f);
+    }
+    if (cp < min || cp > 0x10ffff || (cp >= 0xd800 && cp < 0xe000))
+    {
+        cp = 0xfffd;
+        return 1;
+    }
+    return n;
+}
+
+struct code_point_range
+{
+    char32_t first, last;
+};
+
+template <size_t N>
+bool in_ranges(char32_t cp, const code_point_range (&ranges)[N]) noexcept
+{
+    size_t lo = 0, hi = N;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (cp > ranges[mid].last)
+            lo = mid + 1;
+        else if (cp < ranges[mid].first)
+            hi = mid;
+        else
+            return true;
+    }
+    return false;
+}
+
+/// @brief Number of terminal columns taken by a code point: 0, 1 or 2
+///
+/// Combining marks, variation selectors and zero-width format characters take no space;
+/// East Asian wide and fullwidth characters (and emoji) take two columns.
+inline int column_width(char32_t cp) noexcept
+{
+    static const code_point_range zero_width[] = {
+        { 0x0300, 0x036f }, { 0x0483, 0x0489 }, { 0x0591, 0x05bd }, { 0x0610, 0x061a },
+        { 0x064b, 0x065f }, { 0x0e31, 0x0e31 }, { 0x0e34, 0x0e3a }, { 0x0e47, 0x0e4e },
+        { 0x1ab0, 0x1aff }, { 0x1dc0, 0x1dff }, { 0x200b, 0x200f }, { 0x202a, 0x202e },
+        { 0x2060, 0x2064 }, { 0x20d0, 0x20ff }, { 0x302a, 0x302d }, { 0x3099, 0x309a },
+        { 0xfe00, 0xfe0f }, { 0xfe20, 0xfe2f }, { 0xfeff, 0xfeff }, { 0xe0100, 0xe01ef }
+    };
+    static const code_point_range wide[] = {
+        { 0x1100, 0x115f }, { 0x2329, 0x232a }, { 0x2e80, 0x3029 }, { 0x302e, 0x303e },
+        { 0x3041, 0x3098 }, { 0x309b, 0xa4cf }, { 0xa960, 0xa97f }, { 0xac00, 0xd7a3 },
+        { 0xf900, 0xfaff }, { 0xfe10, 0xfe19 }, { 0xfe30, 0xfe6f }, { 0xff00, 0xff60 },
+        { 0xffe0, 0xffe6 }, { 0x1f300, 0x1f64f }, { 0x1f900, 0x1f9ff }, { 0x20000, 0x2fffd },
+        { 0x30000, 0x3fffd }
+    };
+    if (cp < 0x300)
+        return 1;
+    if (in_ranges(cp, zero_width))
+        return 0;
+    if (in_ranges(cp, wide))
+        return 2;
+    return 1;
+}
+
+/// @brief Measures the longest prefix of a UTF-8 string that fits in `limit` units
+///
+/// ASCII runs are skipped with a vectorized scan; only the non-ASCII characters are decoded.
+/// A character is never split, and zero-width characters following the limit are kept.
+/// @param bytes  receives the length of the prefix, in bytes
+/// @return Width of the prefix, in `unit`s
+inline size_t measure_utf8(const char *str, size_t len, string_width unit, size_t limit, size_t &bytes) noexcept
+{
+    if (unit == string_width::bytes)
+    {
+        bytes = len < limit ? len : limit;
+        return bytes;
+    }
+
+    const char *p = str;
+    const char *end = str + len;
+    size_t width = 0;
+    while (p < end)
+    {
+        const char *ascii_end = simd::find_non_ascii(p, end);
+        size_t run = ascii_end - p;
+        if (run > limit - width)
+        {
+            p += limit - width;
+            width = limit;
+            break;
+        }
+        p = ascii_end;
+        width += run;
+        if (p == end)
+            break;
+
+        char32_t cp;
+        size_t n = decode_utf8(p, end, cp);
+        size_t w = unit == string_width::code_points ? 1 : column_width(cp);
+        if (w > limit - width)
+            break;
+        width += w;
+        p += n;
+    }
+    bytes = p - str;
+    return width;
+}
+
+/// @brief Converts UTF-8 to UTF-16 (16-bit `Char`) or UTF-32 (32-bit `Char`)
+///
+/// Converts as much of `src` as fits in `dst_capacity` code units, without splitting a surrogate
+/// pair. ASCII runs are widened with SIMD; invalid sequences become U+FFFD.
+/// At most `len` code units are produced from `len` bytes.
+/// @param consumed  receives the number of bytes of `src` converted
+/// @return Number of code units written
+template <typename Char>
+size_t utf8_to_wide(Char *dst, size_t dst_capacity, const char *src, size_t len, size_t &consumed) noexcept
+{
+    size_t i = 0, o = 0;
+    while (i < len && o < dst_capacity)
+    {
+        size_t run = len - i < dst_capacity - o ? len - i : dst_capacity - o;
+        size_t ascii = simd::widen_ascii(dst + o, src + i, run);
+        i += ascii;
+        o += ascii;
+        if (ascii == run)
+            continue;
+
+        char32_t cp;
+        size_t n = decode_utf8(src + i, src + len, cp);
+        if (sizeof(Char) == 2 && cp >= 0x10000)
+        {
+            if (dst_capacity - o < 2)
+                break;
+            cp -= 0x10000;
+            dst[o++] = static_cast<Char>(0xd800 + (cp >> 10));
+            dst[o++] = static_cast<Char>(0xdc00 + (cp & 0x3ff));
+        }
+        else
+        {
+            dst[o++] = static_cast<Char>(cp);
+        }
+        i += n;
+    }
+    consumed = i;
+    return o;
+}
+
+/// @brief Encodes a code point as UTF-8; `dst` must have room for 4 bytes
+/// @return Number of bytes written
+inline size_t encode_utf8(char *dst, char32_t cp) noexcept
+{
+    if (cp < 0x80)
+    {
+        dst[0] = static_cast<char>(cp);
+        return 1;
+    }
+    if (cp < 0x800)
+    {
+        dst[0] = static_cast<char>(0xc0 | cp >> 6);
+        dst[1] = static_cast<char>(0x80 | (cp & 0x3f));
+        return 2;
+    }
+    if (cp < 0x10000)
+    {
+        dst[0] = static_cast<char>(0xe0 | cp >> 12);
+        dst[1] = static_cast<char>(0x80 | (cp >> 6 & 0x3f));
+        dst[2] = static_cast<char>(0x80 | (cp & 0x3f));
+        return 3;
+    }
+    dst[0] = static_cast<char>(0xf0 | cp >> 18);
+    dst[1] = static_cast<char>(0x80 | (cp >> 12 & 0x3f));
+    dst[2] = static_cast<char>(0x80 | (cp >> 6 & 0x3f));
+    dst[3] = static_cast<char>(0x80 | (cp & 0x3f));
+    return 4;
+}
+
+/// @brief Converts UTF-16 or UTF-32 to UTF-8; `dst` must have room for `4*len` bytes
+///
+/// Unpaired surrogates and out-of-range values become U+FFFD.
+/// @return Number of bytes written
+template <typename Char>
+size_t wide_to_utf8(char *dst, const Char *src, size_t len) noexcept
+{
+    char *d = dst;
+    for (size_t i = 0; i < len; i++)
+    {
+        char32_t cp = static_cast<char32_t>(src[i]);
+        if (cp < 0x80)
+        {
+            *d++ = static_cast<char>(cp);
+            continue;
+        }
+        if (sizeof(Char) == 2 && cp >= 0xd800 && cp < 0xdc00 && i + 1 < len)
+        {
+            char32_t low = static_cast<char32_t>(src[i + 1]);
+            if (low >= 0xdc00 && low < 0xe000)
+            {
+                cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                i++;
+            }
+        }
+        if ((cp >= 0xd800 && cp < 0xe000) || cp > 0x10ffff)
+            cp = 0xfffd;
+        d += encode_utf8(d, cp);
+    }
+    return d - dst;
+}
+
+} // unicode
+} // formatpp
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef FORMATPP_WIDE_H_
+#define FORMATPP_WIDE_H_
+
+#include "format.h"
+#include "unicode.h"
+#include <ostream>
+#include <string>
+
+namespace formatpp {
+
+namespace detail {
+
+template <typename Char, typename Traits, typename Alloc>
+void append_units(std::basic_string<Char, Traits, Alloc> &s, const Char *str, size_t count)
+{
+    s.append(str, count);
+}
+
+template <typename Char>
+void append_units(char_buf<Char> &s, const Char *str, size_t count)
+{
+    s.append(str, count);
+}
+
+template <typename Char, typename Traits>
+void append_units(std::basic_ostream<Char, Traits> &s, const Char *str, size_t count)
+{
+    s.write(str, count);
+}
+
+template <typename Char, typename Output>
+void append_utf8(Output &out, const char *str, size_t count)
+{
+    enum : size_t { chunk = 256 };
+    Char buf[chunk];
+    while (count)
+    {
+        size_t consumed;
+        size_t n = unicode::utf8_to_wide(buf, chunk, str, count, consumed);
+        append_units(out, buf, n);
+        str += consumed;
+        count -= consumed;
+    }
+}
+
+/// UTF-8 never takes fewer code units than UTF-16/32, so strings are transcoded in place
+template <typename Char, typename Traits, typename Alloc>
+void append_utf8(std::basic_string<Char, Traits, Alloc> &s, const char *str, size_t count)
+{
+    size_t old_size = s.size();
+    s.resize(old_size + count);
+    size_t consumed;
+    size_t n = unicode::utf8_to_wide(&s[old_size], count, str, count, consumed);
+    s.resize(old_size + n);
+}
+
+} // detail
+
+/// @brief An output that receives the (UTF-8) output of the formatters and stores it
+/// as UTF-16 or UTF-32 in `std::basic_string<Char>`, `char_buf<Char>` or `std::basic_ostream<Char>`
+///
+/// Every write is transcoded in bulk: ASCII runs, which include all digits, are widened with SIMD
+/// and only non-ASCII text is decoded. The fill character must be ASCII. String widths and
+/// precisions are counted in code points, as if `u` was given; `w` still selects display columns.
+template <typename Char, typename Output>
+class wide_sink
+{
+public:
+    using char_t = Char;
+
+    explicit wide_sink(Output &output) : output(output) {}
+
+    void append(const char *str, size_t count)
+    {
+        FORMATPP_SINK_WRITE(wide_sink, count);
+        detail::append_utf8<Char>(output, str, count);
+    }
+
+    void append(size_t count, char value)
+    {
+        FORMATPP_SINK_WRITE(wide_sink, count);
+        enum : size_t { chunk = 64 };
+        Char buf[chunk];
+        std::fill_n(buf, detail::min<size_t>(count, chunk), static_cast<Char>(value));
+        while (count)
+        {
+            size_t n = detail::min<size_t>(count, chunk);
+            detail::append_units(output, buf, n);
+            count -= n;
+        }
+    }
+
+    Output &output;
+};
+
+template <typename Char, typename Output>
+struct measures_code_points<wide_sink<Char, Output>> : std::true_type
+{};
+
+template <typename Char, typename Output, typename StringLike>
+inline enable_if_t<is_string_type<StringLike>::value> put(wide_sink<Char, Output> &s, const StringLike &value)
+{
+    s.append(c_str(value), string_length(value));
+}
+
+template <typename Char, typename Output, typename StringLike>
+inline enable_if_t<is_string_type<StringLike>::value>
+put(wide_sink<Char, Output> &s, const StringLike &value, size_t max_len)
+{
+    s.append(c_str(value), detail::min(max_len, string_length(value)));
+}
+
+template <typename Char, typename Output>
+inline void put(wide_sink<Char, Output> &s, size_t n, char value)
+{
+    s.append(n, value);
+}
+
+template <typename Char, typename Output>
+inline void put(wide_sink<Char, Output> &s, char c)
+{
+    s.append(&c, 1);
+}
+
+template <typename Char, typename Output>
+inline void write(wide_sink<Char, Output> &s, const char *str, size_t count)
+{
+    s.append(str, count);
+}
+
+namespace detail {
+
+template <typename Char, typename Output, typename... Args>
+format_errc format_wide_to(Output &out, const char *format_string, Args&&... args)
+{
+    wide_sink<Char, Output> sink(out);
+    return format_to(sink, format_string, std::forward<Args>(args)...);
+}
+
+/// Wide format strings are converted to UTF-8 once, in the context's temporary buffer
+template <typename Char, typename Output, typename... Args>
+format_errc format_wide_to(Output &out, const Char *format_string, Args&&... args)
+{
+    using context = output_context<wide_sink<Char, Output> &>;
+    wide_sink<Char, Output> sink(out);
+    context ctx(sink);
+    size_t len = std::char_traits<Char>::length(format_string);
+    auto narrow = ctx.get_tmp_buffer(4*len + 1);
+    if (!narrow.data)
+        return last_error();
+    narrow.data[unicode::wide_to_utf8(narrow.data, format_string, len)] = 0;
+    return vformat(ctx, const_cast<const char *>(narrow.data),
+            make_format_params<context>(std::forward<Args>(args)...));
+}
+
+} // detail
+
+/// @brief Formats to a UTF-16 or UTF-32 destination; the format string may be narrow (UTF-8) or wide
+template <typename Char, typename Traits, typename Alloc, typename FormatChar, typename... Args>
+format_errc format_wide_to(std::basic_string<Char, Traits, Alloc> &out, const FormatChar *format_string, Args&&... args)
+{
+    return detail::format_wide_to<Char>(out, format_string, std::forward<Args>(args)...);
+}
+
+template <typename Char, typename FormatChar, typename... Args>
+format_errc format_wide_to(char_buf<Char> &out, const FormatChar *format_string, Args&&... args)
+{
+    return detail::format_wide_to<Char>(out, format_string, std::forward<Args>(args)...);
+}
+
+template <typename Char, typename Traits, typename FormatChar, typename... Args>
+format_errc format_wide_to(std::basic_ostream<Char, Traits> &out, const FormatChar *format_string, Args&&... args)
+{
+    return detail::format_wide_to<Char>(out, format_string, std::forward<Args>(args)...);
+}
+
+/// @brief Formats to a new wide string: `format_wide(L"{} items", n)`, `format_wide<char16_t>("{}", x)`
+template <typename Char, typename... Args>
+std::basic_string<Char> format_wide(const Char *format_string, Args&&... args)
+{
+    std::basic_string<Char> str;
+    format_wide_to(str, format_string, std::forward<Args>(args)...);
+    return str;
+}
+
+template <typename Char, typename... Args>
+std::basic_string<Char> format_wide(const char *format_string, Args&&... args)
+{
+    std::basic_string<Char> str;
+    format_wide_to(str, format_string, std::forward<Args>(args)...);
+    return str;
+}
+
+} // formatpp
+
+#endif
@@ -0,0 +1,208 @@
+#include "alloc_counter.h"
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+#include <stdlib.h>
+
+namespace alloc_counter {
+namespace {
+
+// Plain data, so that accessing it never allocates
+thread_local stats thread_stats;
+
+inline void record(size_t size) noexcept
+{
+    thread_stats.allocations++;
+    thread_stats.bytes += size;
+}
+
+} // namespace
+
+stats current() noexcept
+{
+    return thread_stats;
+}
+
+} // alloc_counter
+
+#ifdef __GLIBC__
+
+// Interpose the C allocator, so that allocations made inside the standard library are seen, too
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+
+void *malloc(size_t size)
+{
+    alloc_counter::record(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    alloc_counter::record(n * size);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    alloc_counter::record(size);
+    return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    alloc_counter::record(size);
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    void *p = memalign(alignment, size);
+    if (!p)
+        return ENOMEM;
+    *ptr = p;
+    return 0;
+}
+
+} // extern "C"
+
+namespace {
+
+inline void *allocate(size_t size)
+{
+    return std::malloc(size ? size : 1);
+}
+
+inline void *allocate_aligned(size_t size, size_t alignment)
+{
+    void *p = nullptr;
+    return posix_memalign(&p, alignment < sizeof(void *) ? sizeof(void *) : alignment, size ? size : 1) ? nullptr : p;
+}
+
+} // namespace
+
+#else
+
+namespace {
+
+inline void *allocate(size_t size)
+{
+    alloc_counter::record(size);
+    return std::malloc(size ? size : 1);
+}
+
+inline void *allocate_aligned(size_t size, size_t alignment)
+{
+    alloc_counter::record(size);
+    void *p = nullptr;
+    return posix_memalign(&p, alignment < sizeof(void *) ? sizeof(void *) : alignment, size ? size : 1) ? nullptr : p;
+}
+
+} // namespace
+
+#endif
+
+void *operator new(size_t size)
+{
+    if (void *p = allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    if (void *p = allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+#ifdef __cpp_aligned_new
+
+// Over-aligned types (C++17)
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    if (void *p = allocate_aligned(size, static_cast<size_t>(alignment)))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+    if (void *p = allocate_aligned(size, static_cast<size_t>(alignment)))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocate_aligned(size, static_cast<size_t>(alignment));
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocate_aligned(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef FORMATPP_TEST_ALLOC_COUNTER_H_
+#define FORMATPP_TEST_ALLOC_COUNTER_H_
+
+#include <cstddef>
+
+/// @brief Counts heap allocations made by the current thread
+///
+/// Linking alloc_counter.cpp into an executable replaces the global `operator new` (including
+/// the C++17 aligned forms) and, with glibc, `malloc`, `calloc`, `realloc`, `memalign`,
+/// `aligned_alloc` and `posix_memalign`, so allocations made by the standard library are
+/// counted as well.
+namespace alloc_counter {
+
+struct stats
+{
+    size_t allocations = 0;
+    size_t bytes = 0;
+};
+
+/// @brief Totals for the calling thread since it started
+stats current() noexcept;
+
+/// @brief Allocations made by the calling thread since construction
+class scope
+{
+public:
+    scope() noexcept : start(current()) {}
+
+    stats delta() const noexcept
+    {
+        stats now = current();
+        now.allocations -= start.allocations;
+        now.bytes -= start.bytes;
+        return now;
+    }
+
+    size_t allocations() const noexcept { return delta().allocations; }
+    size_t bytes() const noexcept { return delta().bytes; }
+
+private:
+    stats start;
+};
+
+} // alloc_counter
+
+/// @brief Fails the test if `statement` allocates on the heap
+#define EXPECT_NO_ALLOC(statement) \
+    do \
+    { \
+        ::alloc_counter::scope alloc_scope_; \
+        statement; \
+        EXPECT_EQ(alloc_scope_.allocations(), 0u) << "Unexpected allocation in: " #statement; \
+    } while (0)
+
+#endif
@@ -1,7 +1,9 @@
 #include <formatpp/format.h>
 #include <gtest/gtest.h>
-#include <chrono>
 #include <cmath>
+#include <list>
+#include <map>
+#include <sstream>
 
 using namespace formatpp;
 
@@ -247,6 +249,33 @@ TEST(Formatter, Float)
     formatter<double>().format(ctx, 1-1e-15, ".25g");
     EXPECT_EQ(str.substr(0, 16), "0.99999999999999");
     str = "";
+    // Too many digits for a 64-bit integer
+    formatter<double>().format(ctx, -9.87654321e15, ".3f");
+    EXPECT_EQ(str, "-9876543210000000.000");
+    str = "";
+    formatter<double>().format(ctx, -1e20, ".2f");
+    EXPECT_EQ(str, "-100000000000000000000.00");
+    str = "";
+    formatter<double>().format(ctx, -123456789012345678.0, "f");
+    EXPECT_EQ(str, "-123456789012345680.000000");
+    str = "";
+    formatter<double>().format(ctx, 1.5e19, ".0f");
+    EXPECT_EQ(str, "15000000000000000000");
+    str = "";
+    // Subnormals and values whose rounding would overflow
+    formatter<double>().format(ctx, std::numeric_limits<double>::denorm_min(), ".2e");
+    EXPECT_EQ(str, "4.94e-324");
+    str = "";
+    formatter<float>().format(ctx, std::numeric_limits<float>::denorm_min(), "");
+    EXPECT_EQ(str, "1.40129e-45");
+    str = "";
+    formatter<double>().format(ctx, -std::numeric_limits<double>::max(), ".17e");
+    EXPECT_EQ(str.substr(0, 15), "-1.797693134862");
+    EXPECT_EQ(str.substr(str.size() - 5), "e+308");
+    str = "";
+    formatter<long double>().format(ctx, std::numeric_limits<long double>::denorm_min(), ".2e");
+    EXPECT_EQ(str, "3.64e-4951");
+    str = "";
 }
 
 TEST(Formatter, Float_Inf)
@@ -336,6 +365,70 @@ TEST(Formatter, String)
     str = "";
 }
 
+TEST(Formatter, StringEscape)
+{
+    EXPECT_EQ(format_str("{:j}", "plain text"), "plain text");
+    EXPECT_EQ(format_str("{:j}", "say \"hi\"\n\\ \x01\x7f"), "say \\\"hi\\\"\\n\\\\ \\u0001\x7f");
+    EXPECT_EQ(format_str("{:q}", "tab\there \"\x1b\x7f"), "\"tab\\there \\\"\\033\\177\"");
+    EXPECT_EQ(format_str("{:?}", "a\r\n\"b\"\\\x02"), "a\\r\\n\"b\"\\\\\\x02");
+    EXPECT_EQ(format_str("{:8q}", "a\n"), "   \"a\\n\"");
+    EXPECT_EQ(format_str("{:.3j}", "\"ab\"c"), "\\\"ab");
+
+    // Bytes from 0x80 up (UTF-8 text) are never escaped, also past the vectorized prefix
+    std::string high = std::string(40, 'x') + "z\xc3\xb3\xff\x80";
+    EXPECT_EQ(format_str("{:q}", high), "\"" + high + "\"");
+    EXPECT_EQ(format_str("{:j}", high), high);
+    EXPECT_EQ(format_str("{:?}", high), high);
+    EXPECT_EQ(format_str("{:q}", "\xff\x01"), "\"\xff\\001\"");
+
+    std::string long_str(100, 'x');
+    long_str[70] = '\n';
+    std::string expected = long_str.substr(0, 70) + "\\n" + long_str.substr(71);
+    EXPECT_EQ(format_str("{:j}", long_str), expected);
+}
+
+TEST(Format, Align)
+{
+    EXPECT_EQ(format_str("{:<5}|", 12), "12   |");
+    EXPECT_EQ(format_str("{:>5}|", 12), "   12|");
+    EXPECT_EQ(format_str("{:*^7}", "abc"), "**abc**");
+    EXPECT_EQ(format_str("{:*^6}", "abc"), "*abc**");
+    EXPECT_EQ(format_str("{:>6}", true), "  true");
+    EXPECT_EQ(format_str("{:<6}|", true), "true  |");
+    EXPECT_EQ(format_str("{:6}", false), " false");
+    EXPECT_EQ(format_str("{:-<8.2f}", 1.5), "1.50----");
+    EXPECT_EQ(format_str("{:_>4}", 'x'), "___x");
+    EXPECT_EQ(format_str("{:<6x}|", 255), "ff    |");
+
+    std::stringstream ss;
+    format_to(ss, "{:#>100}", "x");
+    EXPECT_EQ(ss.str(), std::string(99, '#') + "x");
+}
+
+TEST(Formatter, StringUTF8Width)
+{
+    const char *name = "Z\xc3\xbcrich";                   // Zürich
+    EXPECT_EQ(format_str("[{:8}]", name), "[ Z\xc3\xbcrich]");
+    EXPECT_EQ(format_str("[{:8u}]", name), "[  Z\xc3\xbcrich]");
+    EXPECT_EQ(format_str("[{:<8w}]", name), "[Z\xc3\xbcrich  ]");
+    EXPECT_EQ(format_str("[{:.2u}]", name), "[Z\xc3\xbc]");
+    EXPECT_EQ(format_str("[{:.2}]", name), "[Z\xc3]");
+
+    const char *tokyo = "\xe6\x9d\xb1\xe4\xba\xac";        // two wide characters
+    EXPECT_EQ(format_str("[{:6u}]", tokyo), "[    \xe6\x9d\xb1\xe4\xba\xac]");
+    EXPECT_EQ(format_str("[{:6w}]", tokyo), "[  \xe6\x9d\xb1\xe4\xba\xac]");
+    EXPECT_EQ(format_str("[{:.3w}]", tokyo), "[\xe6\x9d\xb1]");
+
+    const char *combined = "e\xcc\x81!";                  // e + combining acute accent
+    EXPECT_EQ(format_str("[{:3w}]", combined), "[ e\xcc\x81!]");
+    EXPECT_EQ(format_str("[{:.1w}]", combined), "[e\xcc\x81]");
+
+    std::string long_str = std::string(40, 'a') + "\xc3\xa9" + std::string(40, 'b') + "\xff";
+    EXPECT_EQ(formatted_size("{:90u}", long_str), long_str.size() + 8);  // 82 code points
+    EXPECT_EQ(format_str("{:.41u}", long_str), long_str.substr(0, 42));
+    EXPECT_EQ(format_str("{:.20u}", long_str), std::string(20, 'a'));
+}
+
 TEST(FormatParams, VariableLength)
 {
     int i = 2;
@@ -370,6 +463,14 @@ TEST(Format, NonIndexed)
     std::stringstream ss;
     format_to(ss, "{:x} or not {}{} == 0x{:X}", 0x2B, 2, 'b', 255);
     EXPECT_EQ(ss.str(), "2b or not 2b == 0xFF");
+
+    EXPECT_EQ(format_str("{:05} {:+} {:6.2}", 123, 5, 1.5), "00123 +5    1.5");
+    EXPECT_EQ(format_str("{}", 'c'), "c");
+
+    const int ci = 7;
+    const double cd = 0.5;
+    const std::string cs = "const";
+    EXPECT_EQ(format_str("{} {} {}", ci, cd, cs), "7 0.5 const");
 }
 
 TEST(Format, Indexed)
@@ -389,6 +490,68 @@ TEST(Format, Braces)
     EXPECT_EQ(format_str("{{{1}{0}}}", 21, 123), "{12321}");;
 }
 
+namespace {
+
+/// Formats to outputs with and without direct (reserve/commit) output and checks that they agree
+template <typename... Args>
+void check_direct_output(const char *format, Args&&... args)
+{
+    std::ostringstream stream;  // no direct output
+    format_to(stream, format, args...);
+    std::string expected = stream.str();
+
+    std::string str = "prefix";
+    format_to(str, format, args...);
+    EXPECT_EQ("prefix" + expected, str) << format;
+
+    char storage[512];
+    char_buf<char> buf(storage, sizeof(storage));
+    format_to(buf, format, args...);
+    EXPECT_EQ(expected, buf.c_str()) << format;
+
+    std::ostringstream buffered_stream;
+    {
+        buffered_sink sink(buffered_stream, 16);
+        format_to(sink, format, args...);
+    }
+    EXPECT_EQ(expected, buffered_stream.str()) << format;
+}
+
+} // namespace
+
+TEST(Format, DirectOutput)
+{
+    const char *int_formats[] = {
+        "{}", "{:5}", "{:<5}", "{:^7}", "{:*>9}", "{:05}", "{:+}", "{:+06}", "{:x}", "{:08X}",
+        "{:b}", "{:o}", "{:.0}", "{:.4}", "{:10.4}", "{:<10.4}", "{:3}",
+    };
+    const int64_t ints[] = { 0, 1, -1, 9, 10, 99, 100, 12345, -12345, 1000000000, INT64_MAX, INT64_MIN + 1 };
+    for (const char *f : int_formats)
+    {
+        for (int64_t v : ints)
+        {
+            check_direct_output(f, v);
+            check_direct_output(f, static_cast<int32_t>(v));
+            check_direct_output(f, static_cast<uint64_t>(v));
+            check_direct_output(f, static_cast<uint8_t>(v));
+        }
+    }
+
+    const char *float_formats[] = {
+        "{}", "{:f}", "{:.3f}", "{:.0f}", "{:12.3f}", "{:<12.3f}", "{:+.2f}", "{:e}", "{:.2e}",
+        "{:14e}", "{:<14.3e}", "{:^16e}", "{:*>14g}", "{:g}", "{:.3g}", "{:10g}", "{:af}", "{:bg}",
+    };
+    const double floats[] = { 0, 1, -1, 0.5, 0.001, 1.5, -2.25, 10, 1234.5678, 1e10, -3.5e-7, 1e20, 123456789.0 };
+    for (const char *f : float_formats)
+    {
+        for (double v : floats)
+        {
+            check_direct_output(f, v);
+            check_direct_output(f, static_cast<float>(v));
+        }
+    }
+}
+
 TEST(TempBuffer, Alloc)
 {
     tmp_buf_allocator alloc;
@@ -407,6 +570,40 @@ TEST(TempBuffer, Alloc)
         EXPECT_EQ(a.used, 0);
 }
 
+TEST(Format, Range)
+{
+    std::vector<int> v = { 1, 10, 255 };
+    EXPECT_EQ(format_str("{}", v), "[1, 10, 255]");
+    EXPECT_EQ(format_str("{:n' ':02x}", v), "01 0a ff");
+    EXPECT_EQ(format_str("{:(';':+}", v), "(+1;+10;+255)");
+    EXPECT_EQ(format_str("{}", std::vector<int>()), "[]");
+
+    const double arr[] = { 0.5, 1.25 };
+    EXPECT_EQ(format_str("{::.2f}", arr), "[0.50, 1.25]");
+
+    std::vector<std::vector<int>> nested = { { 1, 2 }, { 3 } };
+    EXPECT_EQ(format_str("{:n:<}", nested), "<1, 2>, <3>");
+
+    std::map<std::string, int> m = { { "a", 1 }, { "b", 2 } };
+    EXPECT_EQ(format_str("{}", m), "{a: 1, b: 2}");
+
+    std::list<std::string> strings = { "x", "yz" };
+    EXPECT_EQ(format_str("{:n'|':3}", strings), "  x| yz");
+
+    EXPECT_THROW(format_str("{:'unterminated}", v), std::runtime_error);
+    EXPECT_THROW(format_str("{:z}", v), std::runtime_error);
+    EXPECT_THROW(format_str("{:>10}", v), std::runtime_error);
+    EXPECT_THROW(format_str("{:n'|'x}", v), std::runtime_error);
+}
+
+TEST(Format, Tuple)
+{
+    EXPECT_EQ(format_str("{}", std::make_pair(1, "one")), "(1, one)");
+    EXPECT_EQ(format_str("{:n}", std::make_tuple(1, 2.5, 'c')), "1, 2.5, c");
+    std::vector<std::pair<int, bool>> v = { { 1, true } };
+    EXPECT_EQ(format_str("{}", v), "[(1, true)]");
+}
+
 struct CustomType
 {
     int a, b;
@@ -430,67 +627,3 @@ TEST(Format, Custom)
     EXPECT_EQ(format_str("--{0}--", CustomType{4, 5}),
               "--4, 5--");
 }
-
-using perf_clock = std::chrono::high_resolution_clock;
-
-template <typename rep, typename period>
-double ns(std::chrono::duration<rep, period> t)
-{
-    return std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(t).count();
-}
-
-const char *strdata = "asdf";
-
-TEST(Format, Perf)
-{
-    const int outer_N = 100;
-    const int N = 1000;
-    const int total_N = outer_N * N;
-    perf_clock::time_point start, end;
-
-    for (int i = 0; i < 100; i++)
-    {
-        char buf[64];
-        sprintf(buf, "%i %g %s", i, 1.0f/i, "asdf");
-        (void)std::string(buf);
-    }
-    for (int i = 0; i < 100; i++)
-    {
-        (void)format_str("{} {} {}", i, 1.0f/i, "asdf");
-    }
-
-    perf_clock::duration time_format(0), time_sprintf(0), time_stream(0);
-
-    for (int i = 0; i < outer_N; i++)
-    {
-        start = perf_clock::now();
-        for (int i = 0; i < N; i++)
-        {
-            (void)format_str("{} {} {}", i, 1.0/(i+1), strdata);
-        }
-        end = perf_clock::now();
-        time_format += end - start;
-        start = perf_clock::now();
-        for (int i = 0; i < N; i++)
-        {
-            char buf[64];
-            int n = snprintf(buf, 64, "%i %g %s", i, 1.0/(i+1), strdata);
-            (void)std::string(buf, n);
-        }
-        end = perf_clock::now();
-        time_sprintf += end - start;
-
-        start = perf_clock::now();
-        for (int i = 0; i < N; i++)
-        {
-            std::stringstream ss;
-            ss << i << " " << 1.0/i << " " << strdata;
-            (void)ss.str();
-        }
-        end = perf_clock::now();
-        time_stream += end - start;
-    }
-    std::cout << "format_str (dynamic buffer): " << std::round(ns(time_format) / total_N) << "ns" << std::endl;
-    std::cout << "snprintf (fixed buffer + string(buf)): " << std::round(ns(time_sprintf) / total_N) << "ns" << std::endl;
-    std::cout << "stringstream: " << std::round(ns(time_stream) / total_N) << "ns" << std::endl;
-}
@@ -0,0 +1,94 @@
+#include <formatpp/format.h>
+#include <gtest/gtest.h>
+#include "alloc_counter.h"
+#include <sstream>
+#include <stdlib.h>
+#include <string>
+
+using namespace formatpp;
+
+namespace {
+
+struct point
+{
+    int x, y;
+};
+
+std::ostream &operator<<(std::ostream &os, const point &p)
+{
+    return os << "point with coordinates x = " << p.x << ", y = " << p.y;
+}
+
+} // namespace
+
+TEST(Alloc, CounterWorks)
+{
+    alloc_counter::scope scope;
+    std::string s(1000, 'x');
+    EXPECT_GE(scope.allocations(), 1u);
+    EXPECT_GE(scope.bytes(), 1000u);
+}
+
+TEST(Alloc, CounterSeesAlignedAllocations)
+{
+#ifdef __GLIBC__
+    alloc_counter::scope scope;
+    void *p = nullptr;
+    ASSERT_EQ(posix_memalign(&p, 64, 100), 0);
+    free(p);
+    p = aligned_alloc(64, 128);
+    free(p);
+    EXPECT_EQ(scope.allocations(), 2u);
+    EXPECT_EQ(scope.bytes(), 228u);
+#endif
+}
+
+TEST(Alloc, CharBuf)
+{
+    char storage[512];
+    std::string str = "string";
+    EXPECT_NO_ALLOC({
+        char_buf<char> buf(storage, sizeof(storage));
+        format_to(buf, "{} {:x} {:>10} {} {}", 12345, 255u, "abc", true, 'c');
+    });
+    EXPECT_NO_ALLOC({
+        char_buf<char> buf(storage, sizeof(storage));
+        format_to(buf, "{} {:.3f} {:e} {:x}", 1.5, 2.25, 1e100, 0.1);
+    });
+    EXPECT_NO_ALLOC({
+        char_buf<char> buf(storage, sizeof(storage));
+        format_to(buf, "{:*^20} {:.3} {:j} {:10w}", str, str, "a\"b", "Z\xc3\xbcrich");
+    });
+}
+
+TEST(Alloc, ReservedString)
+{
+    std::string out;
+    out.reserve(256);
+    EXPECT_NO_ALLOC({
+        out.clear();
+        format_to(out, "{} {} {}", 42, 0.5, "text");
+    });
+}
+
+TEST(Alloc, FormattedSize)
+{
+    EXPECT_NO_ALLOC(formatted_size("{} {:.10f} {:>30}", 123456789, 3.14159, "right"));
+}
+
+TEST(Alloc, AllocatingPaths)
+{
+    // These paths are known to allocate; make sure the harness sees it
+    char storage[512];
+    alloc_counter::scope ios;
+    {
+        char_buf<char> buf(storage, sizeof(storage));
+        format_to(buf, "{}", point{ 1, 2 });
+    }
+    EXPECT_GT(ios.allocations(), 0u);
+
+    alloc_counter::scope grow;
+    std::string out;
+    format_to(out, "{}", std::string(100, 'x'));
+    EXPECT_GT(grow.allocations(), 0u);
+}
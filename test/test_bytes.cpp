@@ -0,0 +1,47 @@
+#include <formatpp/bytes.h>
+#include <gtest/gtest.h>
+
+using namespace formatpp;
+
+TEST(Bytes, Hex)
+{
+    const uint8_t data[] = { 0xde, 0xad, 0xbe, 0xef, 0x00, 0x01, 0x7f, 0x80, 0xff };
+    EXPECT_EQ(format_str("{}", as_bytes(data, sizeof(data))), "deadbeef00017f80ff");
+    EXPECT_EQ(format_str("{:X}", as_bytes(data, sizeof(data))), "DEADBEEF00017F80FF");
+    EXPECT_EQ(format_str("{:x4}", as_bytes(data, sizeof(data))), "deadbeef 00017f80 ff");
+    EXPECT_EQ(format_str("{:1}", as_bytes(data, 3)), "de ad be");
+    EXPECT_EQ(format_str("[{}]", as_bytes(data, 0)), "[]");
+    EXPECT_THROW(format_str("{:q}", as_bytes(data, 1)), std::runtime_error);
+}
+
+TEST(Bytes, Long)
+{
+    std::vector<uint8_t> data(1000);
+    std::string expected, expected_grouped;
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = static_cast<uint8_t>(i * 7);
+        char buf[3];
+        snprintf(buf, sizeof(buf), "%02X", data[i]);
+        expected += buf;
+        if (i && i % 3 == 0)
+            expected_grouped += ' ';
+        expected_grouped += buf;
+    }
+    EXPECT_EQ(format_str("{:X}", as_bytes(data)), expected);
+    EXPECT_EQ(format_str("{:X3}", as_bytes(data)), expected_grouped);
+}
+
+TEST(Bytes, Dump)
+{
+    std::string s = "Hello, World!\n";
+    s += std::string("\x00\x01\x7f\xff" "abcd", 8);
+    EXPECT_EQ(format_str("{:xd}", as_bytes(s)),
+        "00000000  48 65 6c 6c 6f 2c 20 57  6f 72 6c 64 21 0a 00 01  |Hello, World!...|\n"
+        "00000010  7f ff 61 62 63 64                                 |..abcd|\n"
+        "00000016\n");
+    EXPECT_EQ(format_str("{:xd}", as_bytes(s.data(), 3)),
+        "00000000  48 65 6c                                          |Hel|\n"
+        "00000003\n");
+    EXPECT_EQ(format_str("{:xd}", as_bytes(s.data(), 0)), "");
+}
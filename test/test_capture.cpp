@@ -0,0 +1,150 @@
+#include <formatpp/format.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+using namespace formatpp;
+
+// The tests are built with FORMATPP_CAPTURE defined
+
+namespace {
+
+struct opaque {};
+
+std::ostream &operator<<(std::ostream &os, const opaque &)
+{
+    return os << "opaque";
+}
+
+std::string temp_path(const char *name)
+{
+    return std::string(P_tmpdir) + "/formatpp_" + name + "_" + std::to_string(reinterpret_cast<uintptr_t>(&name));
+}
+
+std::string replay(const capture::captured_call &call)
+{
+    std::string out;
+    output_context<std::string &> ctx(out);
+    dynamic_format_params<output_context<std::string &>> params;
+    capture::add_args(params, call);
+    vformat(ctx, call.format.c_str(), params);
+    return out;
+}
+
+} // namespace
+
+TEST(Capture, RoundTrip)
+{
+    ASSERT_TRUE(capture::enabled);
+    std::string path = temp_path("roundtrip");
+    std::vector<std::string> expected;
+    std::string s;
+    std::string str = "string";
+    char buf_storage[16];
+    char_buf<char> buf(buf_storage, sizeof(buf_storage));
+    buf.append("buf", 3);
+    const char *fmt = "{:>6}|{:x}|{:.3f}";
+
+    ASSERT_TRUE(capture::start(path.c_str()));
+    for (int i = 0; i < 3; i++)
+    {
+        s.clear();
+        format_to(s, fmt, -12345 * i, 255u + i, 1.5f * i);
+        expected.push_back(s);
+    }
+    expected.push_back(format_str("{} {} {} {} {}", true, 'c', str, "literal", buf));
+    expected.push_back(format_str("{} {} {} {}", int8_t(-5), uint16_t(65535), -(int64_t(1) << 40), ~uint64_t()));
+    expected.push_back(format_str("{:e} {}", 1e300, 0.1L));
+    expected.push_back(format_str("no arguments"));
+    std::thread t([]() { format_str("{} from a thread", 42); });
+    t.join();
+    capture::stop();
+    format_str("{} after stop", 1);
+
+    auto calls = capture::read(path.c_str());
+    std::remove(path.c_str());
+    ASSERT_EQ(expected.size() + 1, calls.size());
+    // Each thread's calls are in order, but the threads' buffers are written in any order
+    auto from_thread = std::find_if(calls.begin(), calls.end(), [](const capture::captured_call &c)
+    {
+        return c.format == "{} from a thread";
+    });
+    ASSERT_NE(calls.end(), from_thread);
+    EXPECT_EQ(42, from_thread->args[0].i);
+    calls.erase(from_thread);
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        ASSERT_TRUE(calls[i].replayable());
+        EXPECT_EQ(expected[i], replay(calls[i]));
+    }
+    EXPECT_EQ(fmt, calls[0].format);
+    EXPECT_EQ(capture::arg_type::int32, calls[0].args[0].type);
+    EXPECT_EQ(capture::arg_type::uint32, calls[0].args[1].type);
+    EXPECT_EQ(capture::arg_type::float32, calls[0].args[2].type);
+    EXPECT_EQ(capture::arg_type::string, calls[3].args[2].type);
+    EXPECT_EQ(capture::arg_type::c_string, calls[3].args[3].type);
+    EXPECT_EQ(capture::arg_type::string, calls[3].args[4].type);
+    EXPECT_EQ(capture::arg_type::long_double, calls[5].args[1].type);
+}
+
+TEST(Capture, Sampling)
+{
+    std::string path = temp_path("sampling");
+    ASSERT_TRUE(capture::start(path.c_str(), 4));
+    for (int i = 0; i < 10; i++)
+        format_str("{}", i);
+    capture::stop();
+    auto calls = capture::read(path.c_str());
+    std::remove(path.c_str());
+    ASSERT_EQ(3u, calls.size());
+    EXPECT_EQ(0, calls[0].args[0].i);
+    EXPECT_EQ(4, calls[1].args[0].i);
+    EXPECT_EQ(8, calls[2].args[0].i);
+}
+
+TEST(Capture, ReusedFormatBuffer)
+{
+    std::string path = temp_path("reused");
+    std::string fmt = "A {}";
+    ASSERT_TRUE(capture::start(path.c_str()));
+    for (char c : { 'A', 'B', 'C', 'B' })
+    {
+        // Same address and length, different text
+        fmt[0] = c;
+        format_str(fmt.c_str(), 1);
+    }
+    capture::stop();
+    auto calls = capture::read(path.c_str());
+    std::remove(path.c_str());
+    ASSERT_EQ(4u, calls.size());
+    EXPECT_EQ("A {}", calls[0].format);
+    EXPECT_EQ("B {}", calls[1].format);
+    EXPECT_EQ("C {}", calls[2].format);
+    EXPECT_EQ("B {}", calls[3].format);
+    EXPECT_EQ("C 1", replay(calls[2]));
+}
+
+TEST(Capture, Other)
+{
+    std::string path = temp_path("other");
+    ASSERT_TRUE(capture::start(path.c_str()));
+    format_str("{} {}", opaque(), 1);
+    capture::stop();
+    auto calls = capture::read(path.c_str());
+    std::remove(path.c_str());
+    ASSERT_EQ(1u, calls.size());
+    EXPECT_FALSE(calls[0].replayable());
+    EXPECT_THROW(replay(calls[0]), std::logic_error);
+}
+
+TEST(Capture, Malformed)
+{
+    EXPECT_THROW(capture::parse("garbage", 7), std::runtime_error);
+    std::string data(capture::magic, sizeof(capture::magic));
+    EXPECT_TRUE(capture::parse(data.data(), data.size()).empty());
+    data += "C\x05";
+    EXPECT_THROW(capture::parse(data.data(), data.size()), std::runtime_error);
+    EXPECT_THROW(capture::read("/nonexistent/capture"), std::runtime_error);
+}
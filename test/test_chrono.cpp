@@ -0,0 +1,72 @@
+#include <formatpp/chrono.h>
+#include <gtest/gtest.h>
+
+using namespace formatpp;
+using namespace std::chrono;
+
+TEST(Chrono, Duration)
+{
+    EXPECT_EQ(format_str("{}", milliseconds(1500)), "1500ms");
+    EXPECT_EQ(format_str("{}", seconds(-3)), "-3s");
+    EXPECT_EQ(format_str("{}", minutes(2)), "2min");
+    EXPECT_EQ(format_str("{:.3s}", milliseconds(1500)), "1.500s");
+    EXPECT_EQ(format_str("{:.2ms}", microseconds(-1234)), "-1.23ms");
+    EXPECT_EQ(format_str("{:us}", nanoseconds(123456)), "123us");
+    EXPECT_EQ(format_str("{:.12ns}", nanoseconds(7)), "7.000000000ns");
+    EXPECT_EQ(format_str("{:8.1ms}", microseconds(2500)), "   2.5ms");
+    EXPECT_EQ(format_str("{:.1}", duration<double>(0.25)), "0.2s");
+    EXPECT_EQ(format_str("{:.1ms}", duration<double>(0.25)), "250.0ms");
+    EXPECT_EQ(format_str("{}", duration<int, std::ratio<1, 3>>(2)), "2[1/3]s");
+    EXPECT_EQ(format_str("{:8}", milliseconds(5)), "     5ms");
+    EXPECT_EQ(format_str("{:8ms}", milliseconds(5)), "     5ms");
+    EXPECT_EQ(format_str("{:8.1}", duration<double>(0.25)), "    0.2s");
+    EXPECT_EQ(format_str("{:9}", duration<int, std::ratio<1, 3>>(2)), "  2[1/3]s");
+    EXPECT_EQ(format_str("{:<10ms}", milliseconds(5)), "5ms       ");
+    EXPECT_EQ(format_str("{:*^9.1ms}", microseconds(2500)), "**2.5ms**");
+    EXPECT_EQ(format_str("{:_>6}", seconds(-3)), "___-3s");
+    EXPECT_THROW(format_str("{:mx}", seconds(1)), std::runtime_error);
+}
+
+TEST(Chrono, DurationRounding)
+{
+    // integral and floating-point counts round the same way
+    EXPECT_EQ(format_str("{:.1ms}", microseconds(1999)), "2.0ms");
+    EXPECT_EQ(format_str("{:.1ms}", duration<double, std::micro>(1999)), "2.0ms");
+    EXPECT_EQ(format_str("{:.0ms}", microseconds(-1999)), "-2ms");
+    EXPECT_EQ(format_str("{:.0ms}", duration<double, std::micro>(-1999)), "-2ms");
+    EXPECT_EQ(format_str("{:.2s}", milliseconds(1234)), "1.23s");
+    EXPECT_EQ(format_str("{:.2s}", duration<double, std::milli>(1234)), "1.23s");
+    EXPECT_EQ(format_str("{:.1ms}", microseconds(250)), "0.2ms");
+    EXPECT_EQ(format_str("{:.1ms}", duration<double, std::micro>(250)), "0.2ms");
+    EXPECT_EQ(format_str("{:us}", nanoseconds(123999)), "123us");
+}
+
+TEST(Chrono, TimePoint)
+{
+    // 2021-03-04 05:06:07.089012345 UTC
+    auto t = system_clock::time_point(duration_cast<system_clock::duration>(
+        seconds(1614834367) + nanoseconds(89012345)));
+    EXPECT_EQ(format_str("{:!}", time_point_cast<seconds>(t)), "2021-03-04 05:06:07");
+    EXPECT_EQ(format_str("{:!%H:%M:%S.%3f}", t), "05:06:07.089");
+    EXPECT_EQ(format_str("{:!%T.%f}", t), "05:06:07.089012");
+    EXPECT_EQ(format_str("[{:12!%S.%2f}]", t), "[       07.08]");
+    EXPECT_EQ(format_str("{:!%Y%%%S}", t), "2021%07");
+
+    // cached minute, different seconds
+    auto t2 = t + seconds(30);
+    EXPECT_EQ(format_str("{:!%H:%M:%S.%3f}", t2), "05:06:37.089");
+    auto t3 = t + seconds(60);
+    EXPECT_EQ(format_str("{:!%H:%M:%S.%3f}", t3), "05:07:07.089");
+
+    // E and O modifiers: seconds are cached per second or rendered like %S
+    EXPECT_EQ(format_str("{:!%H:%M:%OS}", t), "05:06:07");
+    EXPECT_EQ(format_str("{:!%H:%M:%OS}", t2), "05:06:37");
+    EXPECT_EQ(format_str("{:!%M:%ES}", t2), "06:37");
+    EXPECT_EQ(format_str("{:!%EX}", t), "05:06:07");
+    EXPECT_EQ(format_str("{:!%EX}", t2), "05:06:37");
+    EXPECT_EQ(format_str("{:!%Ec}", t2), format_str("{:!%c}", t2));
+
+    // before the epoch
+    auto t4 = system_clock::time_point(duration_cast<system_clock::duration>(milliseconds(-1)));
+    EXPECT_EQ(format_str("{:!%Y-%m-%d %H:%M:%S.%3f}", t4), "1969-12-31 23:59:59.999");
+}
@@ -0,0 +1,62 @@
+#include <formatpp/fixed.h>
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+// Built as C++20: integers, booleans, characters and strings are formatted in constant expressions
+
+using namespace formatpp;
+
+static_assert(FORMATPP_CONSTEXPR_FORMAT, "C++20 should enable constant evaluation");
+
+namespace {
+
+FORMATPP_FORMAT_STRING(version_format, "v{}.{}.{}");
+FORMATPP_FORMAT_STRING(header_format, "|{:<8}|{:^8}|{:>8}|");
+FORMATPP_FORMAT_STRING(fragment_format, "{{\"id\":{:#>6x},\"ok\":{:B},\"tag\":{:j}}}");
+
+constexpr auto version = format_fixed<version_format>(1, 12, 3);
+constexpr auto header = format_fixed<header_format>("name", 'x', "size");
+constexpr auto fragment = format_fixed<fragment_format>(0xbeefu, true, "a\"b\n");
+
+constexpr std::array<char, 32> banner(int build)
+{
+    std::array<char, 32> storage{};
+    char_buf<char> buf(storage.data(), storage.size());
+    std::string mode = "release";
+    format_to(buf, "{}-{:04} [{:.3}]", "build", build, mode);
+    return storage;
+}
+
+} // namespace
+
+static_assert(std::string_view(version.c_str()) == "v1.12.3");
+static_assert(version.size() == 7);
+static_assert(std::string_view(header.c_str()) == "|name    |   x    |    size|");
+static_assert(std::string_view(fragment.c_str()) == "{\"id\":##beef,\"ok\":True,\"tag\":a\\\"b\\n}");
+static_assert(std::string_view(banner(42).data()) == "build-0042 [rel]");
+
+static_assert(formatted_size("{:>10}|{}|{:q}", -42, false, "\t") == 10 + 1 + 5 + 1 + 4);
+static_assert(format_str("{:08b} {:+} {:X}", 5, 7, std::numeric_limits<uint64_t>::max()) ==
+              "00000101 +7 FFFFFFFFFFFFFFFF");
+static_assert(format_str("{1}{0}{{}}{:*^5}", 'a', 'b', 'c') == "ba{}**b**");
+static_assert(format_str("{}", std::numeric_limits<int64_t>::min()) == "-9223372036854775808");
+
+TEST(Constexpr, MatchesRuntime)
+{
+    EXPECT_EQ(std::string(version.c_str()), format_str(version_format::get(), 1, 12, 3));
+    EXPECT_EQ(std::string(header.c_str()), format_str(header_format::get(), "name", 'x', "size"));
+    EXPECT_EQ(std::string(fragment.c_str()), format_str(fragment_format::get(), 0xbeefu, true, "a\"b\n"));
+    EXPECT_STREQ(banner(7).data(), "build-0007 [rel]");
+}
+
+TEST(Constexpr, RuntimeStillWorks)
+{
+    // The same functions keep their run-time paths for floats and instrumented builds
+    auto runtime = format_fixed<version_format>(2, 0, -1);
+    EXPECT_STREQ(runtime.c_str(), "v2.0.-1");
+    EXPECT_EQ(format_str("{:.2f} {}", 1.5, true), "1.50 true");
+}
@@ -0,0 +1,67 @@
+#include <formatpp/csv.h>
+#include <gtest/gtest.h>
+
+using namespace formatpp;
+
+TEST(CSV, Field)
+{
+    std::string str;
+    auto dialect = csv_dialect::csv();
+    write_csv_field(str, "plain", 5, dialect);
+    EXPECT_EQ(str, "plain");
+    str = "";
+    write_csv_field(str, "a,b", 3, dialect);
+    EXPECT_EQ(str, "\"a,b\"");
+    str = "";
+    write_csv_field(str, "say \"hi\"", 8, dialect);
+    EXPECT_EQ(str, "\"say \"\"hi\"\"\"");
+    str = "";
+    write_csv_field(str, "line\nbreak", 10, dialect);
+    EXPECT_EQ(str, "\"line\nbreak\"");
+    str = "";
+    std::string long_field = "a rather long field, which exceeds a single vector \"register\"";
+    write_csv_field(str, long_field.c_str(), long_field.length(), dialect);
+    EXPECT_EQ(str, "\"a rather long field, which exceeds a single vector \"\"register\"\"\"");
+}
+
+TEST(CSV, Rows)
+{
+    std::string str;
+    csv_writer<std::string, int, double, std::string, char> csv(str, { "", ".3f", "", "" });
+    csv.write_header({ "id", "value", "name, full", "c" });
+    csv.write_row(1, 2.5, "Smith, John", 'x');
+    csv.write_row(std::make_tuple(-2, 0.125, std::string("Doe"), ','));
+    EXPECT_EQ(str,
+        "id,value,\"name, full\",c\r\n"
+        "1,2.500,\"Smith, John\",x\r\n"
+        "-2,0.125,Doe,\",\"\r\n");
+
+    EXPECT_THROW((csv_writer<std::string, int, int>(str, { "" })), std::logic_error);
+}
+
+TEST(CSV, TSV)
+{
+    std::string str;
+    csv_writer<std::string, unsigned, const char *> tsv(str, { "08x", "" }, csv_dialect::tsv());
+    tsv.write_row(0xbeef, "a,b");
+    tsv.write_row(1, "a\tb");
+    EXPECT_EQ(str, "0000beef\ta,b\n00000001\t\"a\tb\"\n");
+}
+
+TEST(CSV, BufferedSink)
+{
+    std::stringstream ss;
+    {
+        buffered_sink sink(ss, 16);
+        csv_writer<buffered_sink, int, std::string> csv(sink);
+        for (int i = 0; i < 10; i++)
+            csv.write_row(i, "field");
+        EXPECT_LE(sink.buffered(), 16u);
+        csv.write_row(10, std::string(40, 'x'));
+    }
+    std::string expected;
+    for (int i = 0; i < 10; i++)
+        expected += std::to_string(i) + ",field\r\n";
+    expected += "10," + std::string(40, 'x') + "\r\n";
+    EXPECT_EQ(ss.str(), expected);
+}
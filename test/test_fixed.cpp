@@ -0,0 +1,90 @@
+#include <formatpp/fixed.h>
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+using namespace formatpp;
+
+namespace {
+
+FORMATPP_FORMAT_STRING(record_format, "{:08x} {}");
+FORMATPP_FORMAT_STRING(price_format, "{}: {:.3f}");
+FORMATPP_FORMAT_STRING(braces_format, "{{{1}}} {0:>10} {}");
+FORMATPP_FORMAT_STRING(string_format, "[{:.4}|{:<6}|{:j}]");
+FORMATPP_FORMAT_STRING(float_format, "{} {:.2e} {:+012.3}");
+FORMATPP_FORMAT_STRING(extreme_format, "{:+.17e} {:.0f} {:.30}");
+
+template <typename Format, typename... Args>
+void expect_fits(Args &&... args)
+{
+    std::string s = format_str(Format::get(), args...);
+    EXPECT_LE(s.size(), (max_formatted_size<Format, Args...>())) << s;
+    auto fixed = format_fixed<Format>(args...);
+    EXPECT_EQ(std::string(fixed.c_str()), s);
+}
+
+} // namespace
+
+static_assert(max_formatted_size<record_format, uint32_t, int16_t>() == 15, "8 hex digits, a space and -32768");
+static_assert(max_formatted_size<braces_format, bool, char>() == 1 + 1 + 1 + 1 + 10 + 1 + 1, "");
+static_assert(max_formatted_size<string_format, std::string, const char (&)[4], const char (&)[3]>() == 1 + 4 + 1 + 6 + 1 + 14 + 1, "");
+
+TEST(Fixed, Record)
+{
+    uint32_t id = 0xbeef;
+    int16_t value = -32768;
+    auto record = format_fixed<record_format>(id, value);
+    static_assert(std::is_same<decltype(record), fixed_string<15>>::value, "");
+    static_assert(std::is_trivially_copyable<decltype(record)>::value, "");
+    EXPECT_STREQ(record.c_str(), "0000beef -32768");
+    EXPECT_EQ(record.size(), 15u);
+}
+
+TEST(Fixed, ExtremeIntegers)
+{
+    expect_fits<record_format>(std::numeric_limits<uint32_t>::max(), std::numeric_limits<int16_t>::min());
+    expect_fits<record_format>(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::min());
+    expect_fits<record_format>(std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint64_t>::max());
+    expect_fits<braces_format>(true, 'x');
+    expect_fits<braces_format>(std::numeric_limits<int8_t>::min(), false);
+}
+
+TEST(Fixed, ExtremeFloats)
+{
+    for (double x : { 0.0, -1.0, 1e-300, -2.2250738585072014e-308, 123.456, -1.2345e308,
+                      std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() })
+    {
+        expect_fits<float_format>(x, x, x);
+        expect_fits<float_format>(static_cast<float>(x), static_cast<float>(x), static_cast<float>(x));
+    }
+    expect_fits<float_format>(std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), 1.17549435e-38f);
+    for (double x : { 0.0, -1.0, 1e-300, 123.456, -9.87654321e15 })
+        expect_fits<price_format>('p', x);
+    expect_fits<float_format>(-1.1e4000L, 1e-4000L, -1.2e-4931L);
+}
+
+TEST(Fixed, Strings)
+{
+    expect_fits<string_format>(std::string("truncated"), "abc", "\"\n");
+    expect_fits<string_format>(std::string(), "", "");
+}
+
+TEST(Fixed, HugeAndSubnormalFloats)
+{
+    typedef std::numeric_limits<double> dbl;
+    for (double x : { dbl::max(), -dbl::max(), dbl::denorm_min(), -dbl::min() / 3, 0.1 })
+    {
+        expect_fits<extreme_format>(x, x, x);
+        expect_fits<float_format>(x, x, x);
+    }
+    typedef std::numeric_limits<long double> ldbl;
+    for (long double x : { ldbl::max(), -ldbl::max(), ldbl::denorm_min(), -ldbl::min() / 3, 0.1L })
+    {
+        expect_fits<extreme_format>(x, x, x);
+        expect_fits<float_format>(x, x, x);
+    }
+    typedef std::numeric_limits<float> flt;
+    expect_fits<extreme_format>(flt::max(), flt::denorm_min(), -flt::min() / 3);
+}
@@ -0,0 +1,59 @@
+#include <formatpp/net.h>
+#include <gtest/gtest.h>
+
+using namespace formatpp;
+
+namespace {
+
+ipv6_address ipv6(std::initializer_list<unsigned> groups)
+{
+    uint8_t bytes[16] = {};
+    int i = 0;
+    for (unsigned g : groups)
+    {
+        bytes[i++] = g >> 8;
+        bytes[i++] = g & 0xff;
+    }
+    return ipv6_address(bytes);
+}
+
+} // namespace
+
+TEST(Net, IPv4)
+{
+    EXPECT_EQ(format_str("{}", ipv4_address(0x7f000001)), "127.0.0.1");
+    EXPECT_EQ(format_str("{}", ipv4_address(0xffffffff)), "255.255.255.255");
+    const uint8_t b[4] = { 10, 0, 99, 100 };
+    EXPECT_EQ(format_str("[{:12}]", ipv4_address(b)), "[ 10.0.99.100]");
+    EXPECT_EQ(format_str("[{:.<12}]", ipv4_address(b)), "[10.0.99.100.]");
+}
+
+TEST(Net, IPv6)
+{
+    EXPECT_EQ(format_str("{}", ipv6({ 0x2001, 0xdb8, 0, 0, 0, 0, 2, 1 })), "2001:db8::2:1");
+    EXPECT_EQ(format_str("{}", ipv6({ 0x2001, 0xdb8, 0, 1, 1, 1, 1, 1 })), "2001:db8:0:1:1:1:1:1");
+    EXPECT_EQ(format_str("{}", ipv6({ 0x2001, 0, 0, 1, 0, 0, 0, 1 })), "2001:0:0:1::1");
+    EXPECT_EQ(format_str("{}", ipv6({ 0x2001, 0xdb8, 0, 0, 1, 0, 0, 1 })), "2001:db8::1:0:0:1");
+    EXPECT_EQ(format_str("{}", ipv6({ 0, 0, 0, 0, 0, 0, 0, 1 })), "::1");
+    EXPECT_EQ(format_str("{}", ipv6({ 0xfe80, 0, 0, 0, 0, 0, 0, 0 })), "fe80::");
+    EXPECT_EQ(format_str("{}", ipv6({})), "::");
+    EXPECT_EQ(format_str("{:X}", ipv6({ 0xABCD, 0xEF01, 0x2345, 0x6789, 0xABCD, 0xEF01, 0x2345, 0x6789 })),
+              "ABCD:EF01:2345:6789:ABCD:EF01:2345:6789");
+    EXPECT_EQ(format_str("{}", ipv6({ 0, 0, 0, 0, 0, 0xffff, 0xc000, 0x0201 })), "::ffff:192.0.2.1");
+}
+
+TEST(Net, UUID)
+{
+    const uint8_t b[16] = { 0x12, 0x3e, 0x45, 0x67, 0xe8, 0x9b, 0x12, 0xd3,
+                            0xa4, 0x56, 0x42, 0x66, 0x14, 0x17, 0x40, 0x00 };
+    EXPECT_EQ(format_str("{}", uuid(b)), "123e4567-e89b-12d3-a456-426614174000");
+    EXPECT_EQ(format_str("{:X}", uuid(b)), "123E4567-E89B-12D3-A456-426614174000");
+}
+
+TEST(Net, MAC)
+{
+    const uint8_t b[6] = { 0x00, 0x1a, 0x2b, 0x3c, 0x4d, 0xfe };
+    EXPECT_EQ(format_str("{}", mac_address(b)), "00:1a:2b:3c:4d:fe");
+    EXPECT_EQ(format_str("{:X-}", mac_address(b)), "00-1A-2B-3C-4D-FE");
+    EXPECT_THROW(format_str("{:q}", mac_address(b)), std::runtime_error);
+}
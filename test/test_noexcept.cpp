@@ -0,0 +1,76 @@
+#include <formatpp/format.h>
+#include <formatpp/chrono.h>
+#include <formatpp/table.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Built with -fno-exceptions: errors are returned as format_errc
+
+using namespace formatpp;
+
+#ifndef FORMATPP_NO_EXCEPTIONS
+#error "FORMATPP_NO_EXCEPTIONS should be detected with -fno-exceptions"
+#endif
+
+TEST(NoExcept, Success)
+{
+    std::string out;
+    EXPECT_EQ(format_to(out, "{} {:x}", 42, 255), format_errc::ok);
+    EXPECT_EQ(out, "42 ff");
+    EXPECT_EQ(last_error(), format_errc::ok);
+}
+
+TEST(NoExcept, FormatStringErrors)
+{
+    std::string out;
+    EXPECT_EQ(format_to(out, "{} {}", 1), format_errc::argument_index_out_of_range);
+    EXPECT_EQ(format_to(out, "{1a}", 1, 2), format_errc::invalid_format_string);
+    EXPECT_EQ(format_to(out, "{:d", 1), format_errc::invalid_format_string);
+    EXPECT_EQ(format_to(out, "{}", 1), format_errc::ok);
+}
+
+TEST(NoExcept, InvalidSpecifier)
+{
+    std::string out;
+    EXPECT_EQ(format_to(out, "a{:q}b{}", 1, 2), format_errc::invalid_specifier);
+    EXPECT_EQ(out, "a");
+    EXPECT_EQ(format_to(out, "{:z}", 1.5), format_errc::invalid_specifier);
+    EXPECT_EQ(format_to(out, "{:5zs}", std::chrono::milliseconds(5)), format_errc::invalid_specifier);
+    EXPECT_STREQ(message(format_errc::invalid_specifier), "Invalid format specifier");
+}
+
+TEST(NoExcept, FormatStrReportsLastError)
+{
+    std::string s = format_str("{} {}", 1);
+    EXPECT_EQ(last_error(), format_errc::argument_index_out_of_range);
+    s = format_str("{}", 1);
+    EXPECT_EQ(last_error(), format_errc::ok);
+    EXPECT_EQ(s, "1");
+}
+
+TEST(NoExcept, CharBufTruncates)
+{
+    char storage[8];
+    char_buf<char> buf(storage, sizeof(storage));
+    EXPECT_EQ(format_to(buf, "{} {}", "abcd", 12345), format_errc::buffer_overflow);
+    EXPECT_STREQ(buf.c_str(), "abcd 12");
+    EXPECT_EQ(buf.size(), 7u);
+
+    char_buf<char> padded(storage, sizeof(storage));
+    EXPECT_EQ(format_to(padded, "{:>10}", "x"), format_errc::buffer_overflow);
+    EXPECT_STREQ(padded.c_str(), "       ");
+}
+
+TEST(NoExcept, TableArguments)
+{
+    table_formatter<int, int> table({ "a", "b", "c" });
+    EXPECT_EQ(last_error(), format_errc::invalid_argument);
+    // The failed constructor leaves a table without headers
+    std::vector<std::tuple<int, int>> rows = { std::make_tuple(1, 22) };
+    std::string out;
+    table.format(out, rows);
+    EXPECT_EQ(out, "1 22\n");
+}
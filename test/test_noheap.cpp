@@ -0,0 +1,48 @@
+#include <formatpp/format.h>
+#include <gtest/gtest.h>
+#include "alloc_counter.h"
+#include <new>
+
+// Built with FORMATPP_NO_HEAP: temporary buffers spill to a fixed arena instead of the heap
+
+using namespace formatpp;
+
+static_assert(scratch_bound("{} {:>20} {:.3}") <= tmp_buf_allocator::static_buffer_size, "");
+static_assert(scratch_bound("{:%H:%M:%S.%3f}") < 100, "");
+static_assert(scratch_bound("{{:.2000f}}") == 0, "");
+static_assert(scratch_bound("{:.3f}") <= scratch_capacity, "");
+static_assert(scratch_bound("{:>5000}") > scratch_bound("{:>50}"), "");
+static_assert(scratch_bound("{:bf}") > scratch_capacity, "binary positional long doubles don't fit by default");
+
+TEST(NoHeap, WideIntegerSpillsToArena)
+{
+    EXPECT_NO_ALLOC({
+        EXPECT_EQ(formatted_size(FORMATPP_BOUNDED("{:>1000}"), 42), 1000u);
+    });
+    EXPECT_EQ(detail::scratch_arena().used, 0u);
+}
+
+TEST(NoHeap, LargeFloats)
+{
+    char storage[6000];
+    EXPECT_NO_ALLOC({
+        char_buf<char> buf(storage, sizeof(storage));
+        format_to(buf, FORMATPP_BOUNDED("{:.3f} {:.20e} {:>600.3f}"), 1e300, 1.5, 2.5L);
+    });
+    EXPECT_NO_ALLOC({
+        EXPECT_GT(formatted_size(FORMATPP_BOUNDED("{:.3f}"), 1e4000L), 4000u);
+    });
+    EXPECT_EQ(detail::scratch_arena().used, 0u);
+}
+
+TEST(NoHeap, CallerArena)
+{
+    char arena[512];
+    {
+        scratch_scope scope(arena, sizeof(arena));
+        EXPECT_EQ(formatted_size("{:>500}", 1), 500u);
+        EXPECT_THROW(formatted_size("{:>600}", 1), std::bad_alloc);
+        EXPECT_EQ(detail::scratch_arena().used, 0u);
+    }
+    EXPECT_EQ(formatted_size("{:>600}", 1), 600u);
+}
@@ -0,0 +1,86 @@
+#include <formatpp/pool.h>
+#include <gtest/gtest.h>
+#include "alloc_counter.h"
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace formatpp;
+
+TEST(Pool, FormatAndReuse)
+{
+    string_pool pool;
+    const char *data;
+    {
+        pooled_string s = format_pooled(pool, "{} = {:.2f}", "pi", 3.14159);
+        EXPECT_EQ(s.str(), "pi = 3.14");
+        data = s.data();
+    }
+    EXPECT_EQ(pool.free_count(), 1u);
+    pooled_string s = pool.acquire();
+    EXPECT_TRUE(s->empty());
+    EXPECT_EQ(s.data(), data);
+    EXPECT_EQ(pool.free_count(), 0u);
+}
+
+TEST(Pool, MoveAndReset)
+{
+    string_pool pool;
+    pooled_string a = format_pooled(pool, "{}", 42);
+    pooled_string b = std::move(a);
+    EXPECT_FALSE(a);
+    EXPECT_EQ(b.str(), "42");
+    b.reset();
+    EXPECT_FALSE(b);
+    EXPECT_EQ(pool.free_count(), 1u);
+}
+
+TEST(Pool, Limits)
+{
+    string_pool pool(1, 64);
+    {
+        pooled_string big = pool.acquire();
+        big->assign(100, 'x');
+    }
+    EXPECT_EQ(pool.free_count(), 0u);
+    {
+        pooled_string a = pool.acquire(), b = pool.acquire();
+    }
+    EXPECT_EQ(pool.free_count(), 1u);
+}
+
+TEST(Pool, SteadyStateDoesNotAllocate)
+{
+    string_pool pool;
+    pool.preallocate(4, 128);
+    format_pooled(pool, "{} {} {}", 1, 2.5, "warm-up");
+    EXPECT_NO_ALLOC({
+        for (int i = 0; i < 100; i++)
+        {
+            pooled_string s = format_pooled(pool, "message {} from {}: {:.3f}", i, "producer", i * 0.5);
+            EXPECT_GT(s.size(), 0u);
+        }
+    });
+}
+
+TEST(Pool, ReleasedOnAnotherThread)
+{
+    string_pool pool;
+    std::vector<pooled_string> batch;
+    for (int i = 0; i < 10; i++)
+        batch.push_back(format_pooled(pool, "item {}", i));
+    std::thread consumer([&]()
+    {
+        for (int i = 0; i < 10; i++)
+            EXPECT_EQ(batch[i].str(), format_str("item {}", i));
+        batch.clear();
+    });
+    consumer.join();
+    EXPECT_EQ(pool.free_count(), 10u);
+}
+
+TEST(Pool, DefaultPool)
+{
+    pooled_string s = format_pooled("{:>5}", 7);
+    EXPECT_EQ(s.str(), "    7");
+}
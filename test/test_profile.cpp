@@ -0,0 +1,95 @@
+#include <formatpp/format.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace formatpp;
+
+// The tests are built with FORMATPP_PROFILE defined
+
+namespace {
+
+const profile::entry *find_entry(const std::vector<profile::entry> &entries, const std::string &text)
+{
+    for (const auto &e : entries)
+        if (e.text == text)
+            return &e;
+    return nullptr;
+}
+
+} // namespace
+
+TEST(Profile, PerFormatString)
+{
+    ASSERT_TRUE(profile::enabled);
+    profile::reset();
+    std::string s;
+    for (int i = 0; i < 10; i++)
+        format_to(s, "profile test {:5}|", i);
+    format_to(s, "profile other {}", 1.5);
+
+    auto entries = profile::collect();
+    auto *e = find_entry(entries, "profile test {:5}|");
+    ASSERT_NE(nullptr, e);
+    EXPECT_EQ(10u, e->calls);
+    EXPECT_EQ(10u * 19, e->bytes);
+    EXPECT_GE(e->total_ns, e->max_ns);
+
+    auto *other = find_entry(entries, "profile other {}");
+    ASSERT_NE(nullptr, other);
+    EXPECT_EQ(1u, other->calls);
+    EXPECT_EQ(17u, other->bytes);
+
+    for (size_t i = 1; i < entries.size(); i++)
+        EXPECT_GE(entries[i-1].total_ns, entries[i].total_ns);
+}
+
+TEST(Profile, KeyedByAddress)
+{
+    profile::reset();
+    std::string s;
+    const char *fmt = "profile keyed {}";
+    for (int i = 0; i < 3; i++)
+        format_to(s, fmt, i);
+    std::thread t([fmt]()
+    {
+        std::string s;
+        format_to(s, fmt, 42);
+    });
+    t.join();
+    auto *e = find_entry(profile::collect(), "profile keyed {}");
+    ASSERT_NE(nullptr, e);
+    EXPECT_EQ(4u, e->calls);
+}
+
+TEST(Profile, LongFormatStringTruncated)
+{
+    profile::reset();
+    std::string fmt(200, 'x');
+    fmt += "{}";
+    std::string s;
+    format_to(s, fmt.c_str(), 1);
+    auto *e = find_entry(profile::collect(), std::string(63, 'x'));
+    ASSERT_NE(nullptr, e);
+    EXPECT_EQ(201u, e->bytes);
+}
+
+TEST(Profile, Report)
+{
+    profile::reset();
+    std::string s;
+    format_to(s, "profile report {}", 7);
+    std::FILE *f = std::tmpfile();
+    ASSERT_NE(nullptr, f);
+    profile::report(f, 1);
+    std::rewind(f);
+    char line[256];
+    ASSERT_NE(nullptr, std::fgets(line, sizeof(line), f));
+    EXPECT_NE(nullptr, std::strstr(line, "calls"));
+    ASSERT_NE(nullptr, std::fgets(line, sizeof(line), f));
+    EXPECT_NE(nullptr, std::strstr(line, "\"profile report {}\""));
+    EXPECT_EQ(nullptr, std::fgets(line, sizeof(line), f));
+    std::fclose(f);
+}
@@ -0,0 +1,90 @@
+#include <formatpp/simd.h>
+#include <formatpp/format.h>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace formatpp;
+
+namespace {
+
+/// Runs `test` with the kernels of every level up to the detected one
+template <typename Test>
+void for_each_level(Test test)
+{
+    simd::level initial = simd::active_level();
+    for (int i = 0; i <= static_cast<int>(simd::detected_level()); i++)
+    {
+        simd::level l = simd::set_level(static_cast<simd::level>(i));
+        SCOPED_TRACE(simd::level_name(l));
+        test();
+    }
+    simd::set_level(initial);
+}
+
+} // namespace
+
+TEST(Simd, SetLevel)
+{
+    simd::level initial = simd::active_level();
+    EXPECT_EQ(simd::set_level(simd::level::scalar), simd::level::scalar);
+    EXPECT_EQ(simd::active_level(), simd::level::scalar);
+    EXPECT_LE(simd::set_level(simd::level::avx512), simd::detected_level());
+    simd::set_level(initial);
+    EXPECT_STREQ(simd::level_name(simd::level::sse42), "sse4.2");
+}
+
+TEST(Simd, Find)
+{
+    for_each_level([]
+    {
+        std::string s(100, 'a');
+        for (size_t pos : { 0, 5, 15, 16, 31, 32, 33, 70, 99 })
+        {
+            std::string t = s;
+            t[pos] = ',';
+            EXPECT_EQ(simd::find_any_of(t.data(), t.data() + t.size(), ',', '"', '\n', '\r') - t.data(), pos);
+            t[pos] = '\x05';
+            EXPECT_EQ(simd::find_control_or_any_of(t.data(), t.data() + t.size(), '"', '\\', '"') - t.data(), pos);
+            t[pos] = '\xc3';
+            EXPECT_EQ(simd::find_non_ascii(t.data(), t.data() + t.size()) - t.data(), pos);
+        }
+        EXPECT_EQ(simd::find_char(s.data(), s.data() + s.size(), 'b'), s.data() + s.size());
+    });
+}
+
+TEST(Simd, Widen)
+{
+    for_each_level([]
+    {
+        std::string s(70, 'x');
+        s[67] = '\x80';
+        char16_t w16[70];
+        char32_t w32[70];
+        EXPECT_EQ(simd::widen_ascii(w16, s.data(), s.size()), 67u);
+        EXPECT_EQ(simd::widen_ascii(w32, s.data(), s.size()), 67u);
+        EXPECT_EQ(std::u16string(w16, 67), std::u16string(67, u'x'));
+        EXPECT_EQ(std::u32string(w32, 67), std::u32string(67, U'x'));
+    });
+}
+
+TEST(Simd, HexEncode)
+{
+    uint8_t bytes[75];
+    std::string expected_lower, expected_upper;
+    for (int i = 0; i < 75; i++)
+    {
+        bytes[i] = static_cast<uint8_t>(i * 37 + 11);
+        expected_lower += integer_format_options::lowercase_digits()[bytes[i] >> 4];
+        expected_lower += integer_format_options::lowercase_digits()[bytes[i] & 15];
+        expected_upper += integer_format_options::uppercase_digits()[bytes[i] >> 4];
+        expected_upper += integer_format_options::uppercase_digits()[bytes[i] & 15];
+    }
+    for_each_level([&]
+    {
+        char out[150];
+        simd::hex_encode(out, bytes, 75, integer_format_options::lowercase_digits());
+        EXPECT_EQ(std::string(out, 150), expected_lower);
+        simd::hex_encode(out, bytes, 75, integer_format_options::uppercase_digits());
+        EXPECT_EQ(std::string(out, 150), expected_upper);
+    });
+}
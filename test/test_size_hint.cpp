@@ -0,0 +1,66 @@
+#include <formatpp/format.h>
+#include <gtest/gtest.h>
+#include "alloc_counter.h"
+#include <string>
+
+using namespace formatpp;
+
+namespace {
+
+const char line_format[] = "{} | {} | {} | {}";
+
+std::string line(const std::string &field)
+{
+    return format_str(line_format, field, field, field, field);
+}
+
+} // namespace
+
+TEST(SizeHint, ReservesPredictedLength)
+{
+    ASSERT_TRUE(size_hint::enabled);
+    std::string field(40, 'x');
+    EXPECT_EQ(line(field).size(), 169u);
+    EXPECT_EQ(size_hint::estimate(line_format), 169u);
+
+    alloc_counter::scope scope;
+    std::string s = line(field);
+    EXPECT_EQ(scope.allocations(), 1u);
+    EXPECT_EQ(s.size(), 169u);
+    EXPECT_LE(s.capacity(), 180u);
+}
+
+TEST(SizeHint, WeightedMaximum)
+{
+    line(std::string(100, 'x'));
+    size_t high = size_hint::estimate(line_format);
+    EXPECT_EQ(high, 409u);
+    // Shorter outputs lower the estimate gradually; a longer one raises it at once
+    line(std::string(10, 'x'));
+    size_t lowered = size_hint::estimate(line_format);
+    EXPECT_LT(lowered, high);
+    EXPECT_GT(lowered, 49u);
+    for (int i = 0; i < 100; i++)
+        line(std::string(10, 'x'));
+    EXPECT_LT(size_hint::estimate(line_format), 60u);
+    line(std::string(50, 'x'));
+    EXPECT_EQ(size_hint::estimate(line_format), 209u);
+}
+
+TEST(SizeHint, AppendKeepsGrowthGeometric)
+{
+    std::string out;
+    size_t reallocations = 0;
+    const char *data = out.data();
+    for (int i = 0; i < 1000; i++)
+    {
+        format_to(out, "line {:>20}\n", i);
+        if (out.data() != data)
+        {
+            reallocations++;
+            data = out.data();
+        }
+    }
+    EXPECT_EQ(out.size(), 26000u);
+    EXPECT_LT(reallocations, 20u);
+}
@@ -0,0 +1,102 @@
+#include <formatpp/format.h>
+#include <formatpp/wide.h>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace formatpp;
+
+// The tests are built with FORMATPP_STATS defined
+
+namespace {
+
+struct opaque
+{
+    int value;
+};
+
+std::ostream &operator<<(std::ostream &os, const opaque &o)
+{
+    return os << "opaque(" << o.value << ")";
+}
+
+uint64_t delta(const stats::snapshot &before, stats::counter c)
+{
+    return stats::collect()[c] - before[c];
+}
+
+} // namespace
+
+TEST(Stats, Enabled)
+{
+    EXPECT_TRUE(stats::enabled);
+    EXPECT_STREQ("tmp_buffer_spills", stats::name(stats::counter::tmp_buffer_spills));
+    EXPECT_STREQ("bytes_wide_sink", stats::name(stats::counter::bytes_wide_sink));
+}
+
+TEST(Stats, SinkBytes)
+{
+    auto before = stats::collect();
+    std::string s;
+    format_to(s, "{} {:>6}|", 12345, "ab");
+    EXPECT_EQ(s.size(), delta(before, stats::counter::bytes_string));
+
+    std::ostringstream ss;
+    format_to(ss, "{}-{}", 1, 2);
+    EXPECT_EQ(3u, delta(before, stats::counter::bytes_ostream));
+
+    char storage[64];
+    char_buf<char> buf(storage, sizeof(storage));
+    format_to(buf, "{:x}", 255);
+    EXPECT_EQ(2u, delta(before, stats::counter::bytes_char_buf));
+
+    EXPECT_EQ(5u, formatted_size("{:5}", 1));
+    EXPECT_EQ(5u, delta(before, stats::counter::bytes_counting_sink));
+
+    format_wide(L"{}é", 10);
+    EXPECT_EQ(4u, delta(before, stats::counter::bytes_wide_sink));
+}
+
+TEST(Stats, SlowPaths)
+{
+    auto before = stats::collect();
+    EXPECT_EQ("opaque(3)", format_str("{}", opaque{3}));
+    EXPECT_EQ(1u, delta(before, stats::counter::ios_fallback));
+
+    format_str("{:.3f}", 1.5);
+    EXPECT_EQ(0u, delta(before, stats::counter::long_double_positional));
+    format_str("{:.20f}", 1.5);
+    EXPECT_EQ(1u, delta(before, stats::counter::long_double_positional));
+
+    format_str("{:>10}", 1);
+    EXPECT_EQ(0u, delta(before, stats::counter::tmp_buffer_spills));
+    format_str("{:.300f}", 1.5);
+    EXPECT_GE(delta(before, stats::counter::tmp_buffer_spills), 1u);
+}
+
+TEST(Stats, Threads)
+{
+    auto before = stats::collect();
+    std::thread t([]()
+    {
+        std::string s;
+        for (int i = 0; i < 100; i++)
+            format_to(s, "{}", "abcd");
+    });
+    t.join();
+    // The counts of exited threads are retained
+    EXPECT_EQ(400u, delta(before, stats::counter::bytes_string));
+}
+
+TEST(Stats, Reset)
+{
+    std::string s;
+    format_to(s, "{}", 123);
+    EXPECT_GT(stats::collect()[stats::counter::bytes_string], 0u);
+    stats::reset();
+    EXPECT_EQ(0u, stats::collect()[stats::counter::bytes_string]);
+    uint64_t total = 0;
+    stats::collect().for_each([&](const char *, uint64_t value) { total += value; });
+    EXPECT_EQ(0u, total);
+}
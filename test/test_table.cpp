@@ -0,0 +1,88 @@
+#include <formatpp/table.h>
+#include <gtest/gtest.h>
+
+using namespace formatpp;
+
+TEST(Table, Matrix)
+{
+    const int data[] = {
+        1, -20, 300,
+        4000, 5, 6,
+    };
+    std::string str;
+    matrix_formatter<int>().format(str, make_matrix_view(data, 2, 3));
+    EXPECT_EQ(str,
+        "   1 -20 300\n"
+        "4000   5   6\n");
+
+    str = "";
+    matrix_formatter<int> per_column({ "x", "+", "05" });
+    per_column.format(str, make_matrix_view(data, 2, 3));
+    EXPECT_EQ(str,
+        "  1 -20 00300\n"
+        "fa0  +5 00006\n");
+
+    str = "";
+    // 2x2 sub-matrix
+    matrix_formatter<int>().format(str, make_matrix_view(data + 1, 2, 2, 3));
+    EXPECT_EQ(str,
+        "-20 300\n"
+        "  5   6\n");
+}
+
+TEST(Table, MatrixFloat)
+{
+    const double data[] = { 1.5, 1e+10, -0.25, 100 };
+    table_style style;
+    style.column_separator = " | ";
+    std::string str;
+    matrix_formatter<double>(".2f", style).format(str, make_matrix_view(data, 2, 2));
+    EXPECT_EQ(str,
+        " 1.50 | 10000000000.00\n"
+        "-0.25 |         100.00\n");
+
+    EXPECT_EQ(format_str("[{:.1f}]", make_matrix_view(data, 1, 2)),
+              "[1.5 10000000000.0\n]");
+}
+
+TEST(Table, Tuples)
+{
+    std::vector<std::tuple<std::string, int, double>> rows = {
+        std::make_tuple("apples", 3, 0.5),
+        std::make_tuple("kiwi", 120, 12.25),
+    };
+    std::string str;
+    table_formatter<std::string, int, double> table({ "fruit", "n", "price" }, { "", "", ".2f" });
+    table.format(str, rows);
+    EXPECT_EQ(str,
+        " fruit   n price\n"
+        "------ --- -----\n"
+        "apples   3  0.50\n"
+        "  kiwi 120 12.25\n");
+
+    EXPECT_THROW((table_formatter<int, int>({ "a" })), std::logic_error);
+}
+
+TEST(Table, FillAndHeaderAlignment)
+{
+    std::vector<std::tuple<std::string, int>> rows = {
+        std::make_tuple("longname", 1),
+        std::make_tuple("x", 22),
+    };
+    std::string str;
+    table_formatter<std::string, int> table({ "name", "n" }, { "<", "*^" });
+    table.format(str, rows);
+    EXPECT_EQ(str,
+        "name     n \n"
+        "-------- --\n"
+        "longname 1*\n"
+        "x        22\n");
+
+    int data[] = { 1, 100 };
+    EXPECT_EQ(format_str("{:_>}", make_matrix_view(data, 2, 1)), "__1\n100\n");
+}
+
+TEST(Table, FormattedSize)
+{
+    EXPECT_EQ(formatted_size("{} {:08x}", "abc", 255), 12u);
+}
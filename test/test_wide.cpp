@@ -0,0 +1,63 @@
+#include <formatpp/wide.h>
+#include <gtest/gtest.h>
+#include <sstream>
+
+using namespace formatpp;
+
+TEST(Wide, NarrowFormat)
+{
+    EXPECT_EQ(format_wide<wchar_t>("{} + {} = {:.1f}", 1, 2, 3.0), L"1 + 2 = 3.0");
+    EXPECT_EQ(format_wide<char16_t>("[{:>6}]", "ab"), u"[    ab]");
+    EXPECT_EQ(format_wide<char32_t>("{:x}", 255u), U"ff");
+}
+
+TEST(Wide, WideFormat)
+{
+    EXPECT_EQ(format_wide(L"{} items, {:*<4}|", 42, true), L"42 items, true|");
+    EXPECT_EQ(format_wide(u"Grüße, {}!", "Z\xc3\xbcrich"), u"Grüße, Zürich!");
+    EXPECT_EQ(format_wide(U"東京 {{{}}}", 7), U"東京 {7}");
+}
+
+TEST(Wide, Width)
+{
+    // widths and precisions of strings count characters, not UTF-8 bytes
+    EXPECT_EQ(format_wide<char16_t>("[{:>6}]", "\xc3\xa9"), u"[     é]");
+    EXPECT_EQ(format_wide(U"[{:*<4}]", "\xe2\x82\xac\xe2\x82\xac"), U"[€€**]");
+    EXPECT_EQ(format_wide(L"[{:.2}]", "\xc3\xa9t\xc3\xa9"), L"[ét]");
+    EXPECT_EQ(format_wide<char16_t>("[{:4w}]", "\xe6\x9d\xb1"), u"[  東]");
+    EXPECT_EQ(format_str("[{:>6}]", "\xc3\xa9"), "[    \xc3\xa9]");
+}
+
+TEST(Wide, Transcoding)
+{
+    // Long ASCII runs exercise the vectorized path, interrupted by 2-, 3- and 4-byte sequences
+    std::string ascii(37, 'a');
+    std::string text = ascii + "\xc3\xa9" + ascii + "\xe2\x82\xac" + ascii + "\xf0\x9f\x98\x80" + ascii + "\xff";
+    std::u16string expected16 = std::u16string(37, u'a') + u"é" + std::u16string(37, u'a') + u"€" +
+                                std::u16string(37, u'a') + u"\U0001F600" + std::u16string(37, u'a') + u"�";
+    EXPECT_EQ(format_wide<char16_t>("{}", text), expected16);
+
+    std::u32string expected32 = std::u32string(37, U'a') + U"é" + std::u32string(37, U'a') + U"€" +
+                                std::u32string(37, U'a') + U"\U0001F600" + std::u32string(37, U'a') + U"�";
+    EXPECT_EQ(format_wide<char32_t>("{}", text), expected32);
+
+    std::string long_text(1000, 'x');
+    long_text += "\xc3\xa9";
+    EXPECT_EQ(format_wide<wchar_t>("{}", long_text), std::wstring(1000, L'x') + L"é");
+}
+
+TEST(Wide, Outputs)
+{
+    std::wostringstream ss;
+    format_wide_to(ss, "{}-{}", 1, 2);
+    EXPECT_EQ(ss.str(), L"1-2");
+
+    char16_t storage[32];
+    char_buf<char16_t> buf(storage, 32);
+    format_wide_to(buf, u"{:05}", 42);
+    EXPECT_EQ(std::u16string(buf.c_str()), u"00042");
+
+    std::u16string s = u"x=";
+    format_wide_to(s, "{}", 1.5);
+    EXPECT_EQ(s, u"x=1.5");
+}